@@ -0,0 +1,118 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Bump allocator for everything that lives as long as one translation.
+// arena_reset() rewinds it without returning blocks to malloc, so repeated
+// translations of similar inputs reach a steady state with no mallocs.
+
+#define ARENA_BLOCK_SIZE (256 * 1024)
+#define ARENA_ALIGN 16
+
+typedef struct ArenaBlock
+{
+    struct ArenaBlock *next;
+    size_t used;
+    size_t size;
+    _Alignas(ARENA_ALIGN) char data[];
+} ArenaBlock;
+
+typedef struct
+{
+    ArenaBlock *first;
+    ArenaBlock *current;
+    size_t blockCount;
+    size_t bytesReserved;
+    size_t bytesUsed;
+    size_t peakBytesUsed;
+} Arena;
+
+static void arena_init(Arena *arena)
+{
+    memset(arena, 0, sizeof(Arena));
+}
+
+static void *arena_alloc(Arena *arena, size_t size)
+{
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    ArenaBlock *block = arena->current;
+    while (block && block->used + size > block->size)
+    {
+        block = block->next;
+        if (block)
+        {
+            block->used = 0;
+        }
+    }
+
+    if (!block)
+    {
+        size_t blockSize = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+        block = malloc(sizeof(ArenaBlock) + blockSize);
+        if (!block)
+        {
+            perror("Failed to allocate arena block");
+            exit(EXIT_FAILURE);
+        }
+        block->next = NULL;
+        block->used = 0;
+        block->size = blockSize;
+        if (arena->current)
+        {
+            // Keep retained blocks reachable after the new one.
+            block->next = arena->current->next;
+            arena->current->next = block;
+        }
+        else
+        {
+            arena->first = block;
+        }
+        arena->blockCount++;
+        arena->bytesReserved += blockSize;
+    }
+
+    arena->current = block;
+    void *memory = block->data + block->used;
+    block->used += size;
+    arena->bytesUsed += size;
+    if (arena->bytesUsed > arena->peakBytesUsed)
+    {
+        arena->peakBytesUsed = arena->bytesUsed;
+    }
+    return memory;
+}
+
+static char *arena_strndup(Arena *arena, const char *text, size_t length)
+{
+    char *copy = arena_alloc(arena, length + 1);
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+static void arena_reset(Arena *arena)
+{
+    arena->current = arena->first;
+    if (arena->first)
+    {
+        arena->first->used = 0;
+    }
+    arena->bytesUsed = 0;
+}
+
+static void arena_free(Arena *arena)
+{
+    ArenaBlock *block = arena->first;
+    while (block)
+    {
+        ArenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+    arena_init(arena);
+}
+
+#endif
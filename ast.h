@@ -0,0 +1,118 @@
+#ifndef AST_H
+#define AST_H
+
+#include <stdint.h>
+#include <string.h>
+#include "arena.h"
+
+// Syntax tree built by the parser and walked by semantic analysis and code
+// generation. All nodes live in one contiguous array and refer to each other
+// by 32-bit index (first child, next sibling), so building a tree costs no
+// per-node allocation and a walk reads memory mostly front to back.
+// Nodes point back at tokens instead of copying them. The array comes from
+// the arena; call ast_init() again after a reset.
+
+#define AST_NONE UINT32_MAX
+
+typedef enum
+{
+    NODE_PROGRAM,
+    NODE_PREPROCESSOR,
+    NODE_FUNCTION,      // token: name; children: NODE_PARAM..., body NODE_BLOCK
+    NODE_PARAM,         // token: name; the type is the token before it
+    NODE_BLOCK,         // token: '{'; children: statements
+    NODE_DECLARATION,   // token: data type; children: NODE_DECLARATOR...
+    NODE_DECLARATOR,    // token: name; child: initialiser NODE_EXPRESSION
+    NODE_EXPRESSION,    // children: operands and operators, left to right
+    NODE_NAME,          // token: identifier
+    NODE_NUMBER,        // token: number
+    NODE_STRING,        // token: string literal
+    NODE_OPERATOR,      // token: OP or ASSIGNMENT
+    NODE_PAREN,         // token: '('; child: NODE_EXPRESSION
+    NODE_EXPRESSION_STATEMENT,
+    NODE_CALL,          // token: callee; child: NODE_TOKENS arguments
+    NODE_FUNCTION_CALL, // token: library function; children: NODE_EXPRESSION...
+    NODE_RETURN,        // child: NODE_EXPRESSION
+    NODE_IF,            // children: condition, NODE_BLOCK, optional NODE_ELSE
+    NODE_ELSE,          // child: NODE_BLOCK
+    NODE_WHILE,         // children: condition, NODE_BLOCK
+    NODE_DO_WHILE,      // children: NODE_BLOCK, condition
+    NODE_FOR,           // tokens [token + 1, tokenEnd) are the header;
+                        // children: initialiser, condition and step names, NODE_BLOCK
+    NODE_SWITCH,        // children: subject, NODE_BLOCK of NODE_CASE
+    NODE_CASE,          // token: 'case', followed by its label; children: statements
+    NODE_DEFAULT,       // children: statements
+    NODE_BREAK,
+    NODE_OUTPUT,        // children: format NODE_STRING, argument NODE_NAME...
+    NODE_INPUT,         // child: NODE_TOKENS from '(' to ')'
+    NODE_COMMENT,
+    NODE_TOKENS,        // tokens [token, tokenEnd) the grammar leaves unstructured
+    NODE_CACHED         // token: function name; tokenEnd: index of the cached
+                        // translation that stands in for the whole function
+} NodeKind;
+
+typedef struct
+{
+    uint32_t kind; // NodeKind
+    uint32_t token;
+    uint32_t tokenEnd;
+    uint32_t firstChild;
+    uint32_t nextSibling;
+} AstNode;
+
+typedef struct
+{
+    AstNode *nodes;
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t root;
+    Arena *arena;
+} Ast;
+
+static void ast_init(Ast *ast, Arena *arena)
+{
+    memset(ast, 0, sizeof(Ast));
+    ast->arena = arena;
+    ast->root = AST_NONE;
+}
+
+// Returns the index of a new childless node. Indices stay valid as the
+// array grows; AstNode pointers do not.
+static uint32_t ast_node(Ast *ast, NodeKind kind, uint32_t token)
+{
+    if (ast->count == ast->capacity)
+    {
+        uint32_t capacity = ast->capacity ? ast->capacity * 2 : 4096;
+        AstNode *nodes = arena_alloc(ast->arena, sizeof(AstNode) * capacity);
+        if (ast->nodes)
+        {
+            memcpy(nodes, ast->nodes, sizeof(AstNode) * ast->count);
+        }
+        ast->nodes = nodes;
+        ast->capacity = capacity;
+    }
+    ast->nodes[ast->count] = (AstNode){kind, token, token + 1, AST_NONE, AST_NONE};
+    return ast->count++;
+}
+
+// Appends child to parent's child list in O(1). *last is the previous child
+// appended to this parent, AST_NONE before the first. AST_NONE children are
+// ignored, so optional parts can be appended unconditionally.
+static void ast_append(Ast *ast, uint32_t parent, uint32_t *last, uint32_t child)
+{
+    if (child == AST_NONE)
+    {
+        return;
+    }
+    if (*last == AST_NONE)
+    {
+        ast->nodes[parent].firstChild = child;
+    }
+    else
+    {
+        ast->nodes[*last].nextSibling = child;
+    }
+    *last = child;
+}
+
+#endif
@@ -0,0 +1,309 @@
+#define _XOPEN_SOURCE 700
+#include <ftw.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "batch.h"
+#include "clock.h"
+#include "libc2js.h"
+#include "source.h"
+
+typedef struct
+{
+    char *path;
+    char *outputPath;
+    size_t size;
+    C2jsResult result;
+    bool ioFailed;
+    int errorLine;
+    int errorColumn;
+    size_t bytesOut;
+    double seconds;
+    C2jsStats stats;
+} BatchJob;
+
+typedef struct
+{
+    BatchJob *jobs;
+    int jobCount;
+    int *order; // job indices, largest file first
+    atomic_int next;
+    C2jsCache *cache; // shared by every worker, or NULL
+} BatchQueue;
+
+static BatchJob *collectedJobs;
+static int collectedCount;
+static int collectedCapacity;
+
+static void add_job(const char *path, size_t size)
+{
+    if (collectedCount == collectedCapacity)
+    {
+        collectedCapacity = collectedCapacity ? collectedCapacity * 2 : 256;
+        collectedJobs = realloc(collectedJobs, sizeof(BatchJob) * collectedCapacity);
+        if (!collectedJobs)
+        {
+            perror("Failed to allocate batch jobs");
+            exit(EXIT_FAILURE);
+        }
+    }
+    collectedJobs[collectedCount++] = (BatchJob){.path = strdup(path), .size = size};
+}
+
+static int collect_source(const char *path, const struct stat *st, int flag, struct FTW *ftw)
+{
+    size_t length = strlen(path);
+    if (flag == FTW_F && length > 2 && strcmp(path + length - 2, ".c") == 0)
+    {
+        add_job(path, st->st_size);
+    }
+    return 0;
+}
+
+static int compare_paths(const void *a, const void *b)
+{
+    return strcmp(((const BatchJob *)a)->path, ((const BatchJob *)b)->path);
+}
+
+static bool read_manifest(const char *manifest)
+{
+    FILE *file = fopen(manifest, "r");
+    if (!file)
+    {
+        return false;
+    }
+    char line[4096];
+    while (fgets(line, sizeof(line), file))
+    {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '#')
+        {
+            continue;
+        }
+        struct stat st;
+        add_job(line, stat(line, &st) == 0 ? (size_t)st.st_size : 0);
+    }
+    fclose(file);
+    return true;
+}
+
+void batch_make_parent_dirs(char *path)
+{
+    for (char *slash = strchr(path + 1, '/'); slash; slash = strchr(slash + 1, '/'))
+    {
+        *slash = '\0';
+        mkdir(path, 0777);
+        *slash = '/';
+    }
+}
+
+char *batch_output_path(const char *path, const char *root, const char *outputDir)
+{
+    size_t length = strlen(path);
+    size_t stem = length > 2 && strcmp(path + length - 2, ".c") == 0 ? length - 2 : length;
+    if (!outputDir)
+    {
+        char *output = malloc(stem + 4);
+        sprintf(output, "%.*s.js", (int)stem, path);
+        return output;
+    }
+
+    // Mirror the input tree under outputDir.
+    const char *relative = path;
+    if (root && strncmp(path, root, strlen(root)) == 0)
+    {
+        relative += strlen(root);
+    }
+    while (*relative == '/' || strncmp(relative, "./", 2) == 0)
+    {
+        relative += *relative == '/' ? 1 : 2;
+    }
+    stem -= relative - path;
+    char *output = malloc(strlen(outputDir) + stem + 5);
+    sprintf(output, "%s/%.*s.js", outputDir, (int)stem, relative);
+    return output;
+}
+
+static void translate_job(C2jsContext *ctx, OutputSink *output, BatchJob *job)
+{
+    double start = now_seconds();
+    SourceFile source;
+    if (!source_open(job->path, &source))
+    {
+        job->ioFailed = true;
+        return;
+    }
+    job->size = source.length;
+
+    sink_reset(output);
+    job->result = c2js_translate_buffer(ctx, source.data, source.length, output);
+    job->stats = *c2js_last_stats(ctx);
+
+    if (job->result == C2JS_OK)
+    {
+        batch_make_parent_dirs(job->outputPath);
+        if (sink_save(output, job->outputPath))
+        {
+            job->bytesOut = output->length;
+        }
+        else
+        {
+            job->ioFailed = true;
+        }
+    }
+    else
+    {
+        job->errorLine = c2js_error_line(ctx);
+        job->errorColumn = c2js_error_column(ctx);
+    }
+    source_close(&source);
+    job->seconds = now_seconds() - start;
+}
+
+static void *batch_worker(void *arg)
+{
+    BatchQueue *queue = arg;
+    C2jsContext *ctx = c2js_context_new();
+    // Per-file results are reported from the job table instead.
+    c2js_set_trace_level(ctx, C2JS_TRACE_OFF);
+    c2js_set_cache(ctx, queue->cache);
+    // One output buffer per worker, reused for every file it translates.
+    OutputSink output;
+    sink_init_memory(&output);
+
+    for (int next = atomic_fetch_add(&queue->next, 1); next < queue->jobCount; next = atomic_fetch_add(&queue->next, 1))
+    {
+        translate_job(ctx, &output, &queue->jobs[queue->order[next]]);
+    }
+
+    sink_close(&output);
+    c2js_context_free(ctx);
+    return NULL;
+}
+
+static BatchJob *sizeSortJobs;
+
+static int compare_size_descending(const void *a, const void *b)
+{
+    size_t sizeA = sizeSortJobs[*(const int *)a].size;
+    size_t sizeB = sizeSortJobs[*(const int *)b].size;
+    return sizeA < sizeB ? 1 : sizeA > sizeB ? -1 : *(const int *)a - *(const int *)b;
+}
+
+int run_batch(const BatchOptions *options)
+{
+    struct stat st;
+    if (stat(options->input, &st) != 0)
+    {
+        perror(options->input);
+        return 1;
+    }
+    bool isDirectory = S_ISDIR(st.st_mode);
+    if (isDirectory)
+    {
+        nftw(options->input, collect_source, 64, FTW_PHYS);
+        qsort(collectedJobs, collectedCount, sizeof(BatchJob), compare_paths);
+    }
+    else if (!read_manifest(options->input))
+    {
+        perror(options->input);
+        return 1;
+    }
+
+    BatchQueue queue = {.jobs = collectedJobs, .jobCount = collectedCount};
+    queue.order = malloc(sizeof(int) * (collectedCount + 1));
+    for (int i = 0; i < collectedCount; i++)
+    {
+        collectedJobs[i].outputPath = batch_output_path(collectedJobs[i].path, isDirectory ? options->input : NULL, options->outputDir);
+        queue.order[i] = i;
+    }
+    // Largest files first, so one big file does not become the tail.
+    sizeSortJobs = collectedJobs;
+    qsort(queue.order, collectedCount, sizeof(int), compare_size_descending);
+    atomic_init(&queue.next, 0);
+    if (options->cacheDir && !(queue.cache = c2js_cache_open(options->cacheDir, options->cacheBytes)))
+    {
+        perror(options->cacheDir);
+    }
+
+    int threads = options->threads > 0 ? options->threads : (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads > collectedCount)
+    {
+        threads = collectedCount > 0 ? collectedCount : 1;
+    }
+
+    double start = now_seconds();
+    pthread_t *workers = malloc(sizeof(pthread_t) * threads);
+    int started = 0;
+    int error = 0;
+    while (started < threads && (error = pthread_create(&workers[started], NULL, batch_worker, &queue)) == 0)
+    {
+        started++;
+    }
+    if (started < threads)
+    {
+        fprintf(stderr, "Started %d of %d workers: %s\n", started, threads, strerror(error));
+        threads = started > 0 ? started : 1;
+    }
+    // Without any worker, this thread does the work.
+    if (started == 0)
+    {
+        batch_worker(&queue);
+    }
+    for (int i = 0; i < started; i++)
+    {
+        pthread_join(workers[i], NULL);
+    }
+    double wall = now_seconds() - start;
+    c2js_cache_close(queue.cache);
+
+    // Report in input order, whatever order the workers finished in.
+    int failed = 0;
+    size_t bytesIn = 0;
+    size_t bytesOut = 0;
+    double busy = 0;
+    C2jsStats stats = {0};
+    for (int i = 0; i < collectedCount; i++)
+    {
+        BatchJob *job = &collectedJobs[i];
+        const char *status = job->ioFailed ? "io-error"
+                             : job->result == C2JS_SYNTAX_ERROR   ? "syntax-error"
+                             : job->result == C2JS_SEMANTIC_ERROR ? "semantic-error"
+                             : job->result == C2JS_TOO_LARGE      ? "too-large"
+                                                                  : "ok";
+        failed += job->ioFailed || job->result != C2JS_OK;
+        bytesIn += job->size;
+        bytesOut += job->bytesOut;
+        busy += job->seconds;
+        c2js_stats_add(&stats, &job->stats);
+        printf("%-14s %10zu bytes %9.3f ms %9.2f MB/s  %s", status, job->size, job->seconds * 1e3,
+               job->seconds > 0 ? job->size / job->seconds / 1e6 : 0.0, job->path);
+        if (job->result == C2JS_SYNTAX_ERROR)
+        {
+            printf(" (line %d, column %d)", job->errorLine, job->errorColumn);
+        }
+        printf("\n");
+    }
+    printf("%d files, %d failed, %d threads: %zu bytes in, %zu bytes out, %.3f s wall, %.3f s busy, %.2f MB/s\n",
+           collectedCount, failed, threads, bytesIn, bytesOut, wall, busy, wall > 0 ? bytesIn / wall / 1e6 : 0.0);
+    if (options->stats)
+    {
+        // Phase times add up across workers; wall time is the batch's own.
+        stats.wallSeconds = wall;
+        fflush(stdout);
+        c2js_stats_print(stderr, &stats, options->statsFormat);
+    }
+
+    for (int i = 0; i < collectedCount; i++)
+    {
+        free(collectedJobs[i].path);
+        free(collectedJobs[i].outputPath);
+    }
+    free(collectedJobs);
+    free(queue.order);
+    free(workers);
+    return failed ? 1 : 0;
+}
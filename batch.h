@@ -0,0 +1,31 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdbool.h>
+#include "libc2js.h"
+
+// Translates every .c file under a directory, or every path listed in a
+// manifest file (one per line), on a pool of worker threads.
+
+typedef struct
+{
+    const char *input;     // directory or manifest
+    const char *outputDir; // NULL writes each .js next to its .c
+    int threads;           // 0 picks the number of online CPUs
+    bool stats;            // print combined C2jsStats to stderr
+    C2jsStatsFormat statsFormat;
+    const char *cacheDir;  // NULL disables the translation cache
+    size_t cacheBytes;     // cap on the cache's size
+} BatchOptions;
+
+// Returns 0 when every file translated successfully.
+int run_batch(const BatchOptions *options);
+
+// foo/bar.c -> foo/bar.js, or <outputDir>/bar.js when root is foo. root may
+// be NULL. The result is malloc()ed.
+char *batch_output_path(const char *path, const char *root, const char *outputDir);
+
+// Creates every missing directory above path.
+void batch_make_parent_dirs(char *path);
+
+#endif
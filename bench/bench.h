@@ -0,0 +1,28 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+// Setup shared by the benchmarks that include libc2js.c to time single
+// pipeline phases. Include after ../libc2js.c.
+
+// Lexes source into ctx as a translation would, ready for bench_parse().
+// source must outlive ctx's tokens.
+static void bench_tokenize(C2jsContext *ctx, const char *source, size_t length)
+{
+    reset_translation(ctx);
+    ctx->source = source;
+    tokenize(&ctx->interner, &ctx->tokenStore, source, length);
+    ctx->tokens = ctx->tokenStore;
+}
+
+// Parses the tokens of bench_tokenize(), or exits if they do not parse.
+static void bench_parse(C2jsContext *ctx)
+{
+    if (setjmp(ctx->syntaxError))
+    {
+        printf("FAIL: generated input does not parse (line %d)\n", ctx->errorLine);
+        exit(1);
+    }
+    parse(ctx);
+}
+
+#endif
@@ -0,0 +1,100 @@
+#include "../clock.h"
+#include "../lexer.h"
+
+// Identifier classification: the perfect hash in keywords.h against the
+// original per-table strcmp chain, plus tokenize() on identifier-heavy input.
+// Usage: classify_bench [identifiers]   (default 2,000,000)
+
+static const char *reference_tables[][10] = {
+    {"auto", "break", "case", "const", "continue", "default", "do", "enum", "goto", "return"},
+    {"int", "char", "float", "double", "void", "long long", "long", "short", "unsigned", "signed"},
+    {"for", "while", "do"},
+    {"if", "else", "switch", "case", "default"},
+    {"strcmp", "strcpy"},
+    {"scanf", "getchar", "getch", "getche"},
+    {"printf", "putchar", "puts"},
+};
+static const TokenType reference_types[] = {KEYWORDS, DATA_TYPES, LOOP, CONDITIONAL, FUNCTION, INPUTS, OUTPUTS};
+
+// The isKeyword/isDataType/... chain tokenize() used before keywords.h.
+static TokenType classify_reference(const char *text, size_t length)
+{
+    char *id = strndup(text, length);
+    TokenType type = ID;
+    for (int t = 0; t < 7 && type == ID; t++)
+    {
+        for (int w = 0; w < 10 && reference_tables[t][w]; w++)
+        {
+            if (strcmp(id, reference_tables[t][w]) == 0)
+            {
+                type = reference_types[t];
+                break;
+            }
+        }
+    }
+    free(id);
+    return type;
+}
+
+static const char *words[] = {
+    "count", "index", "total", "value", "buffer", "result", "i", "j", "sum", "temp",
+    "int", "for", "if", "printf", "return", "while", "char", "else", "scanf", "node"};
+
+int main(int argc, char **argv)
+{
+    size_t identifiers = argc > 1 ? strtoull(argv[1], NULL, 10) : 2000000;
+    size_t wordCount = sizeof(words) / sizeof(words[0]);
+
+    char *source = malloc(identifiers * 8 + 1);
+    size_t length = 0;
+    srand(42);
+    for (size_t i = 0; i < identifiers; i++)
+    {
+        const char *word = words[rand() % wordCount];
+        length += sprintf(source + length, "%s ", word);
+    }
+
+    const char *end = source + length;
+    size_t checksum = 0;
+    double start = now_seconds();
+    for (const char *p = source; p < end;)
+    {
+        const char *q = strchr(p, ' ');
+        checksum += classify_reference(p, q - p);
+        p = q + 1;
+    }
+    double reference = now_seconds() - start;
+
+    start = now_seconds();
+    for (const char *p = source; p < end;)
+    {
+        const char *q = strchr(p, ' ');
+        KeywordId keyword;
+        checksum -= classify_identifier(p, q - p, &keyword);
+        p = q + 1;
+    }
+    double hashed = now_seconds() - start;
+
+    Arena arena;
+    Interner interner;
+    arena_init(&arena);
+    interner_init(&interner, &arena);
+    TokenStream tokens = {0};
+    start = now_seconds();
+    tokenize(&interner, &tokens, source, length);
+    double lexing = now_seconds() - start;
+
+    printf("strcmp chain:   %8.2f ns/identifier\n", reference * 1e9 / identifiers);
+    printf("perfect hash:   %8.2f ns/identifier (%.1fx)\n", hashed * 1e9 / identifiers, reference / hashed);
+    printf("tokenize:       %8.2f ns/identifier, %.0f tokens/sec\n", lexing * 1e9 / identifiers, tokens.count / lexing);
+    if (checksum != 0)
+    {
+        printf("classifiers disagree\n");
+        return 1;
+    }
+
+    token_stream_free(&tokens);
+    arena_free(&arena);
+    free(source);
+    return 0;
+}
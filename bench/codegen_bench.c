@@ -0,0 +1,58 @@
+#include <fcntl.h>
+#include "../libc2js.c"
+#include "bench.h"
+#include "corpus.h"
+
+// Code generator throughput on its own: generated input (see corpus.h) is
+// lexed and parsed once, then convert_to_javascript_with_main_call() is
+// timed into a memory sink and into a file-descriptor sink.
+// Usage: codegen_bench [source_bytes] [output_file]
+//        (default 20 MB, written to /dev/null)
+
+static void report(const char *target, size_t bytes, double seconds)
+{
+    printf("%-8s %12zu %10.4f %10.1f\n", target, bytes, seconds, bytes / seconds / 1e6);
+}
+
+int main(int argc, char **argv)
+{
+    size_t size = argc > 1 ? strtoull(argv[1], NULL, 10) : 20u * 1000 * 1000;
+    const char *outputPath = argc > 2 ? argv[2] : "/dev/null";
+
+    size_t length;
+    char *source = corpus_source(size, 1, &length);
+
+    C2jsContext *ctx = c2js_context_new();
+    c2js_set_trace_level(ctx, C2JS_TRACE_OFF);
+    bench_tokenize(ctx, source, length);
+    bench_parse(ctx);
+
+    printf("%-8s %12s %10s %10s\n", "target", "bytes out", "seconds", "MB/s");
+    OutputSink memory;
+    sink_init_memory(&memory);
+    for (int run = 0; run < 3; run++)
+    {
+        sink_reset(&memory);
+        double start = now_seconds();
+        convert_to_javascript_with_main_call(ctx, &memory);
+        report("memory", memory.length, now_seconds() - start);
+    }
+    size_t outputLength = memory.length;
+    sink_close(&memory);
+
+    for (int run = 0; run < 3; run++)
+    {
+        int fd = open(outputPath, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+        OutputSink file;
+        sink_init_fd(&file, fd);
+        double start = now_seconds();
+        convert_to_javascript_with_main_call(ctx, &file);
+        sink_close(&file);
+        report("fd", outputLength, now_seconds() - start);
+        close(fd);
+    }
+
+    c2js_context_free(ctx);
+    free(source);
+    return 0;
+}
@@ -0,0 +1,347 @@
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "../output_sink.h"
+
+// Seeded generator of C translation units for benchmarks. The output uses
+// only what the translator accepts (functions, declarations, for, while,
+// do-while, if/else, switch/case/default, printf, scanf, calls, comments),
+// declares every name before using it, and so translates without errors.
+// The same size and seed always give the same bytes. Output streams into
+// an OutputSink, so sizes up to gigabytes need no buffer of that size.
+
+typedef struct
+{
+    OutputSink *out;
+    uint64_t rng;
+    // Names visible at the current point; scopeMarks[i] is the count when
+    // scope i was entered.
+    int names[256];
+    int nameCount;
+    int scopeMarks[16];
+    int depth;
+    int nextName;
+    int functionCount;
+} Corpus;
+
+// xorshift64*: fast, and identical on every platform.
+static uint32_t corpus_random(Corpus *corpus)
+{
+    corpus->rng ^= corpus->rng >> 12;
+    corpus->rng ^= corpus->rng << 25;
+    corpus->rng ^= corpus->rng >> 27;
+    return (uint32_t)((corpus->rng * 2685821657736338717ull) >> 32);
+}
+
+// Uniform enough in [0, n) for generating code.
+static int corpus_pick(Corpus *corpus, int n)
+{
+    return (int)(corpus_random(corpus) % (uint32_t)n);
+}
+
+static void corpus_printf(Corpus *corpus, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+static void corpus_printf(Corpus *corpus, const char *format, ...)
+{
+    char text[256];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    sink_write(corpus->out, text, length < (int)sizeof(text) ? (size_t)length : sizeof(text) - 1);
+}
+
+static void corpus_indent(Corpus *corpus)
+{
+    for (int i = 0; i < corpus->depth; i++)
+    {
+        sink_literal(corpus->out, "    ");
+    }
+}
+
+static void corpus_enter(Corpus *corpus)
+{
+    corpus->scopeMarks[corpus->depth++] = corpus->nameCount;
+}
+
+static void corpus_leave(Corpus *corpus)
+{
+    corpus->nameCount = corpus->scopeMarks[--corpus->depth];
+}
+
+// Returns the number of a fresh local. Once names[] is full, new locals are
+// still declared but never picked for use.
+static int corpus_declare(Corpus *corpus)
+{
+    if (corpus->nameCount < 256)
+    {
+        corpus->names[corpus->nameCount++] = corpus->nextName;
+    }
+    return corpus->nextName++;
+}
+
+static void corpus_operand(Corpus *corpus)
+{
+    if (corpus->nameCount > 0 && corpus_pick(corpus, 3) > 0)
+    {
+        corpus_printf(corpus, "v%d", corpus->names[corpus_pick(corpus, corpus->nameCount)]);
+    }
+    else
+    {
+        corpus_printf(corpus, "%d", corpus_pick(corpus, 1000));
+    }
+}
+
+static void corpus_expression(Corpus *corpus, int nesting)
+{
+    static const char *operators[] = {" + ", " - ", " * ", " / ", " % "};
+    int terms = 1 + corpus_pick(corpus, 4);
+    for (int i = 0; i < terms; i++)
+    {
+        if (i > 0)
+        {
+            sink_write(corpus->out, operators[corpus_pick(corpus, 5)], 3);
+        }
+        if (nesting < 2 && corpus_pick(corpus, 6) == 0)
+        {
+            sink_literal(corpus->out, "(");
+            corpus_expression(corpus, nesting + 1);
+            sink_literal(corpus->out, ")");
+        }
+        else
+        {
+            corpus_operand(corpus);
+        }
+    }
+}
+
+static void corpus_condition(Corpus *corpus)
+{
+    corpus_operand(corpus);
+    sink_write(corpus->out, corpus_pick(corpus, 2) ? " < " : " > ", 3);
+    corpus_expression(corpus, 1);
+}
+
+static void corpus_statements(Corpus *corpus, int count);
+
+// An indented { ... } block in its own scope.
+static void corpus_block(Corpus *corpus, int statements)
+{
+    sink_literal(corpus->out, "{\n");
+    corpus_enter(corpus);
+    corpus_statements(corpus, statements);
+    corpus_leave(corpus);
+    corpus_indent(corpus);
+    sink_literal(corpus->out, "}");
+}
+
+static void corpus_declaration(Corpus *corpus)
+{
+    int kind = corpus_pick(corpus, 8);
+    if (kind == 0)
+    {
+        // Not added to the usable names: arrays never appear in expressions.
+        corpus_printf(corpus, "char s%d[%d];\n", corpus->nextName++, 16 << corpus_pick(corpus, 4));
+        return;
+    }
+    if (kind == 1)
+    {
+        int first = corpus_declare(corpus);
+        int second = corpus_declare(corpus);
+        corpus_printf(corpus, "int v%d, v%d;\n", first, second);
+        return;
+    }
+    static const char *types[] = {"int", "int", "long", "float", "double"};
+    sink_write(corpus->out, types[kind % 5], strlen(types[kind % 5]));
+    // Each initialiser may use the names declared before it, including
+    // earlier ones in the same list, but not its own.
+    int count = 1 + corpus_pick(corpus, 2);
+    for (int i = 0; i < count; i++)
+    {
+        corpus_printf(corpus, "%sv%d = ", i == 0 ? " " : ", ", corpus->nextName);
+        corpus_expression(corpus, 0);
+        corpus_declare(corpus);
+    }
+    sink_literal(corpus->out, ";\n");
+}
+
+static void corpus_statement(Corpus *corpus, int budget)
+{
+    int name = corpus->nameCount > 0 ? corpus->names[corpus_pick(corpus, corpus->nameCount)] : -1;
+    int kind = corpus_pick(corpus, budget > 0 && corpus->depth < 6 ? 14 : 8);
+    corpus_indent(corpus);
+    if (name < 0 || kind < 3)
+    {
+        corpus_declaration(corpus);
+    }
+    else if (kind == 3)
+    {
+        corpus_printf(corpus, "v%d = ", name);
+        corpus_expression(corpus, 0);
+        sink_literal(corpus->out, ";\n");
+    }
+    else if (kind == 4)
+    {
+        corpus_printf(corpus, "v%d%s;\n", name, corpus_pick(corpus, 2) ? "++" : "--");
+    }
+    else if (kind == 5)
+    {
+        int other = corpus->names[corpus_pick(corpus, corpus->nameCount)];
+        corpus_printf(corpus, "printf(\"v%d = %%d, v%d = %%d\\n\", v%d, v%d);\n", name, other, name, other);
+    }
+    else if (kind == 6)
+    {
+        corpus_printf(corpus, "scanf(\"%%d\", &v%d);\n", name);
+    }
+    else if (kind == 7)
+    {
+        if (corpus->functionCount > 0)
+        {
+            corpus_printf(corpus, "f%d(v%d, %d);\n", corpus_pick(corpus, corpus->functionCount), name, corpus_pick(corpus, 100));
+        }
+        else
+        {
+            sink_literal(corpus->out, "// nothing to call yet\n");
+        }
+    }
+    else if (kind == 8)
+    {
+        sink_literal(corpus->out, "if(");
+        corpus_condition(corpus);
+        sink_literal(corpus->out, ")");
+        corpus_block(corpus, budget);
+        if (corpus_pick(corpus, 2))
+        {
+            sink_literal(corpus->out, "\n");
+            corpus_indent(corpus);
+            sink_literal(corpus->out, "else");
+            corpus_block(corpus, budget);
+        }
+        sink_literal(corpus->out, "\n");
+    }
+    else if (kind == 9)
+    {
+        sink_literal(corpus->out, "while(");
+        corpus_condition(corpus);
+        sink_literal(corpus->out, ")");
+        corpus_block(corpus, budget);
+        sink_literal(corpus->out, "\n");
+    }
+    else if (kind == 10)
+    {
+        sink_literal(corpus->out, "do");
+        corpus_block(corpus, budget);
+        sink_literal(corpus->out, "while(");
+        corpus_condition(corpus);
+        sink_literal(corpus->out, ");\n");
+    }
+    else if (kind == 11)
+    {
+        // The loop variable is visible in the body only.
+        int mark = corpus->nameCount;
+        int counter = corpus_declare(corpus);
+        corpus_printf(corpus, "for(int v%d=0; v%d<%d; v%d++)", counter, counter, 1 + corpus_pick(corpus, 100), counter);
+        corpus_block(corpus, budget);
+        corpus->nameCount = mark;
+        sink_literal(corpus->out, "\n");
+    }
+    else if (kind == 12)
+    {
+        corpus_printf(corpus, "switch(v%d){\n", name);
+        corpus->depth++;
+        int cases = 1 + corpus_pick(corpus, 3);
+        for (int i = 0; i < cases; i++)
+        {
+            corpus_indent(corpus);
+            corpus_printf(corpus, "case %d:\n", i + 1);
+            corpus_enter(corpus);
+            corpus_statements(corpus, 1 + corpus_pick(corpus, 2));
+            corpus_leave(corpus);
+            corpus_indent(corpus);
+            sink_literal(corpus->out, "    break;\n");
+        }
+        corpus_indent(corpus);
+        sink_literal(corpus->out, "default:\n");
+        corpus_enter(corpus);
+        corpus_statements(corpus, 1);
+        corpus_leave(corpus);
+        corpus_indent(corpus);
+        sink_literal(corpus->out, "    break;\n");
+        corpus->depth--;
+        corpus_indent(corpus);
+        sink_literal(corpus->out, "}\n");
+    }
+    else
+    {
+        corpus_printf(corpus, "/* block %d */\n", corpus_pick(corpus, 1000));
+    }
+}
+
+// count statements, each of which may nest fewer statements.
+static void corpus_statements(Corpus *corpus, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        corpus_statement(corpus, count / 2);
+    }
+}
+
+static void corpus_function(Corpus *corpus, const char *returnType, const char *name, bool parameters)
+{
+    corpus->nameCount = 0;
+    corpus->nextName = 0;
+    corpus->depth = 0;
+    corpus_enter(corpus);
+    if (parameters)
+    {
+        int first = corpus_declare(corpus);
+        int second = corpus_declare(corpus);
+        corpus_printf(corpus, "%s %s(int v%d, int v%d){\n", returnType, name, first, second);
+    }
+    else
+    {
+        corpus_printf(corpus, "%s %s(){\n", returnType, name);
+    }
+    corpus_statements(corpus, 3 + corpus_pick(corpus, 10));
+    if (strcmp(returnType, "int") == 0)
+    {
+        corpus_indent(corpus);
+        sink_literal(corpus->out, "return(");
+        corpus_expression(corpus, 1);
+        sink_literal(corpus->out, ");\n");
+    }
+    corpus_leave(corpus);
+    sink_literal(corpus->out, "}\n\n");
+}
+
+// Writes about size bytes (at least one main function) to out.
+static void corpus_generate(OutputSink *out, size_t size, uint64_t seed)
+{
+    Corpus corpus = {.out = out, .rng = seed * 0x9E3779B97F4A7C15ull + 1};
+    size_t start = sink_total(out);
+    sink_literal(out, "#include <stdio.h>\n\n");
+    // main() averages under 1 KB; leave room for it.
+    while (sink_total(out) - start + 1024 < size)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "f%d", corpus.functionCount);
+        corpus_function(&corpus, corpus_pick(&corpus, 2) ? "int" : "void", name, true);
+        corpus.functionCount++;
+    }
+    corpus_function(&corpus, "int", "main", false);
+}
+
+// corpus_generate() into a new heap buffer of *length bytes; free() it.
+static char *corpus_source(size_t size, uint64_t seed, size_t *length)
+{
+    OutputSink out;
+    sink_init_memory(&out);
+    corpus_generate(&out, size, seed);
+    *length = out.length;
+    return out.data;
+}
+
+#endif
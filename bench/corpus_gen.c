@@ -0,0 +1,28 @@
+#include <stdlib.h>
+#include "corpus.h"
+
+// Writes a generated C translation unit to stdout, for feeding project2 or
+// a batch run with inputs of a chosen size.
+// Usage: corpus_gen SIZE [SEED]   SIZE in bytes, with an optional K, M or G
+//                                 suffix (powers of 1000); SEED defaults to 1
+
+static size_t parse_size(const char *text)
+{
+    char *suffix;
+    double size = strtod(text, &suffix);
+    double scale = *suffix == 'K' || *suffix == 'k' ? 1e3 : *suffix == 'M' || *suffix == 'm' ? 1e6 : *suffix == 'G' || *suffix == 'g' ? 1e9 : 1;
+    return (size_t)(size * scale);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: corpus_gen SIZE [SEED]\n");
+        return 2;
+    }
+    OutputSink out;
+    sink_init_fd(&out, STDOUT_FILENO);
+    corpus_generate(&out, parse_size(argv[1]), argc > 2 ? strtoull(argv[2], NULL, 10) : 1);
+    return sink_close(&out) ? 0 : 1;
+}
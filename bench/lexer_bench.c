@@ -0,0 +1,97 @@
+#include "../clock.h"
+#include "../lexer.h"
+#include "corpus.h"
+
+// Lexer throughput across input sizes, on generated input (see corpus.h).
+// Usage: lexer_bench [max_bytes]   (default 100 MB)
+//        lexer_bench --check       check how '&' lexes, then lex 1, 10 and
+//                                  100 MB and fail unless time grows
+//                                  near-linearly with size
+
+static double run(size_t size)
+{
+    size_t length;
+    char *source = corpus_source(size, 1, &length);
+    Arena arena;
+    Interner interner;
+    arena_init(&arena);
+    interner_init(&interner, &arena);
+    TokenStream tokens = {0};
+
+    double start = now_seconds();
+    tokenize(&interner, &tokens, source, length);
+    double elapsed = now_seconds() - start;
+
+    printf("%12zu %12d %10.4f %14.0f\n", length, tokens.count, elapsed, tokens.count / elapsed);
+
+    token_stream_free(&tokens);
+    arena_free(&arena);
+    free(source);
+    return elapsed / length;
+}
+
+// '&' before a letter is scanf's address-of, which keeps the name up to the
+// closing paren for codegen; every other '&' goes to the punctuator DFA.
+static bool check_ampersands()
+{
+    static const char *source = "a && b; x &= y; x & y; scanf(\"%d\", &n);";
+    static const char *expected = "<ID, a> <OP, &&> <ID, b> <SEMICOLON, ;> <ID, x> <ASSIGNMENT, &=> <ID, y> "
+                                  "<SEMICOLON, ;> <ID, x> <OP, &> <ID, y> <SEMICOLON, ;> <INPUTS, scanf> <LPAREN, (> "
+                                  "<STRING, %d> <COMMA, ,> <ID, n> <RPAREN, )> <SEMICOLON, ;> <T_EOF, EOF>";
+    Arena arena;
+    Interner interner;
+    arena_init(&arena);
+    interner_init(&interner, &arena);
+    TokenStream tokens = {0};
+    tokenize(&interner, &tokens, source, strlen(source));
+    char dump[1024];
+    size_t length = 0;
+    for (int i = 0; i < tokens.count; i++)
+    {
+        length += snprintf(dump + length, sizeof(dump) - length, "%s<%s, %.*s>", i ? " " : "", token_type_strings[tokens.types[i]],
+                           TOKEN_TEXT(source, tokens, i));
+    }
+    bool ok = strcmp(dump, expected) == 0;
+    if (!ok)
+    {
+        printf("FAIL: %s lexes as\n  %s\nrather than\n  %s\n", source, dump, expected);
+    }
+    token_stream_free(&tokens);
+    arena_free(&arena);
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    bool check = argc > 1 && strcmp(argv[1], "--check") == 0;
+    size_t maxBytes = argc > 1 && !check ? strtoull(argv[1], NULL, 10) : 100u * 1024 * 1024;
+
+    if (check && !check_ampersands())
+    {
+        return 1;
+    }
+    printf("%12s %12s %10s %14s\n", "bytes", "tokens", "seconds", "tokens/sec");
+    if (!check)
+    {
+        for (size_t size = 1024; size <= maxBytes; size *= 10)
+        {
+            run(size);
+        }
+        return 0;
+    }
+
+    // Seconds per byte may drift with cache effects but must not grow with size.
+    double perByte = run(1000000);
+    for (size_t size = 10000000; size <= 100000000; size *= 10)
+    {
+        double next = run(size);
+        if (next > perByte * 2)
+        {
+            printf("FAIL: lexing %zu bytes is %.1fx slower per byte than the previous size\n", size, next / perByte);
+            return 1;
+        }
+        perByte = next;
+    }
+    printf("OK: lexing time grows linearly with input size\n");
+    return 0;
+}
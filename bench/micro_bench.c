@@ -0,0 +1,426 @@
+#include "../libc2js.c"
+#include "bench.h"
+#include "corpus.h"
+#include "stats.h"
+
+// Microbenchmarks for single subsystems: tokenize() on inputs dominated by
+// one kind of lexeme, keyword classification, symbol table declare/lookup
+// at several table sizes, and code generation. Each benchmark runs a batch
+// of operations per sample; after the warmup samples, the median, minimum
+// and median absolute deviation of ns/op over the timed samples are
+// reported. Times are CPU time, so descheduling does not count.
+// Usage: micro_bench [--samples N] [--warmup N] [--filter TEXT]
+//                    [--json FILE] [--compare FILE] [--threshold PERCENT]
+//                    [--scan scalar|sse2|avx2]
+//        --scan caps the lexer's scan kernels (scan.h) at the given level;
+//        --json writes the results as JSON, one benchmark per line;
+//        --compare reads such a file and fails if any benchmark's median is
+//        more than PERCENT (default 10) slower than in the file.
+
+typedef struct
+{
+    C2jsContext *ctx;
+    char *source;
+    size_t length;
+    uint32_t *names;  // symtab: intern IDs to declare or look up
+    uint32_t count;   // symtab: table size
+    Arena tableArena; // symtab: reset for every fresh table
+    OutputSink output; // codegen
+} MicroState;
+
+typedef struct
+{
+    const char *name;
+    const char *unit; // what one op is
+    void (*setup)(MicroState *state, int arg);
+    size_t (*run)(MicroState *state); // returns the ops done
+    int arg;
+} MicroBench;
+
+typedef struct
+{
+    char name[64];
+    double median;
+    double min;
+    double mad;
+} MicroResult;
+
+static volatile size_t micro_sink;
+
+// About 1 MB of repetitions of one line.
+static void set_source(MicroState *state, const char *line)
+{
+    size_t lineLength = strlen(line);
+    size_t size = 1000 * 1000;
+    state->source = malloc(size + lineLength);
+    state->length = 0;
+    while (state->length < size)
+    {
+        memcpy(state->source + state->length, line, lineLength);
+        state->length += lineLength;
+    }
+}
+
+static void setup_lex(MicroState *state, int kind)
+{
+    static const char *lines[] = {
+        "alpha beta_2 gamma delta epsilon zeta_eta theta iota kappa lambda mu\n",
+        "12 3.25 1000000 42 7 0.5 65535 99 314159 2.71828 8 16 256\n",
+        "\"a string literal\" \"with %d format\" \"and more text inside\"\n",
+        "/* a block comment that goes on for a while */ // and a line comment\n",
+        "a+=b-c*d; x<=y&&z!=w||!v; i++; j--; k<<=2; m>>1; p->q; (r%s)^~t;\n",
+    };
+    set_source(state, lines[kind]);
+}
+
+static size_t run_lex(MicroState *state)
+{
+    reset_translation(state->ctx);
+    tokenize(&state->ctx->interner, &state->ctx->tokenStore, state->source, state->length);
+    micro_sink = state->ctx->tokenStore.count;
+    return state->length;
+}
+
+static void setup_classify(MicroState *state, int keywords)
+{
+    static const char *keywordLines = "int for while printf return char if else switch scanf void double\n";
+    static const char *identifierLines = "count index total value buffer result node left right sum next\n";
+    set_source(state, keywords ? keywordLines : identifierLines);
+}
+
+static size_t run_classify(MicroState *state)
+{
+    size_t ops = 0;
+    size_t hits = 0;
+    const char *p = state->source;
+    const char *end = state->source + state->length;
+    while (p < end)
+    {
+        const char *word = p;
+        while (*p != ' ' && *p != '\n')
+        {
+            p++;
+        }
+        KeywordId keyword;
+        hits += classify_identifier(word, p - word, &keyword) != ID;
+        ops++;
+        p++;
+    }
+    micro_sink = hits;
+    return ops;
+}
+
+// Interns count distinct names, shuffled so lookups do not walk the table
+// in order. The interner keeps pointers to the text, so each name is copied
+// into the context's arena rather than interned from the buffer.
+static void setup_symtab(MicroState *state, int count)
+{
+    C2jsContext *ctx = state->ctx;
+    reset_translation(ctx);
+    arena_init(&state->tableArena);
+    state->count = count;
+    state->names = malloc(sizeof(uint32_t) * count);
+    char name[32];
+    for (int i = 0; i < count; i++)
+    {
+        int length = snprintf(name, sizeof(name), "name%d", i);
+        state->names[i] = intern(&ctx->interner, arena_strndup(&ctx->arena, name, length), length);
+    }
+    uint64_t rng = 88172645463325252ull;
+    for (int i = count - 1; i > 0; i--)
+    {
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        int j = (int)(rng % (uint64_t)(i + 1));
+        uint32_t swap = state->names[i];
+        state->names[i] = state->names[j];
+        state->names[j] = swap;
+    }
+}
+
+// Small tables are filled or searched repeatedly so a sample is not all
+// overhead.
+static uint32_t symtab_rounds(const MicroState *state)
+{
+    return state->count < 100000 ? 100000 / state->count : 1;
+}
+
+// Declares every name in a fresh table inside one scope.
+static size_t run_symtab_declare(MicroState *state)
+{
+    SymbolTable *table = &state->ctx->symbols;
+    uint32_t rounds = symtab_rounds(state);
+    for (uint32_t round = 0; round < rounds; round++)
+    {
+        arena_reset(&state->tableArena);
+        symtab_init(table, &state->tableArena);
+        symtab_enter_scope(table);
+        for (uint32_t i = 0; i < state->count; i++)
+        {
+            symtab_declare(table, state->names[i], 0);
+        }
+        symtab_leave_scope(table);
+    }
+    return (size_t)rounds * state->count;
+}
+
+// setup_symtab(), then declares every name in a table that holds them all.
+static void setup_symtab_lookup(MicroState *state, int count)
+{
+    setup_symtab(state, count);
+    SymbolTable *table = &state->ctx->symbols;
+    symtab_init(table, &state->tableArena);
+    for (uint32_t i = 0; i < state->count; i++)
+    {
+        symtab_declare(table, state->names[i], 0);
+    }
+    if (table->used != state->count)
+    {
+        printf("FAIL: %u names made %u symbols\n", state->count, table->used);
+        exit(1);
+    }
+}
+
+// Looks every name up in the table setup_symtab_lookup() built.
+static size_t run_symtab_lookup(MicroState *state)
+{
+    SymbolTable *table = &state->ctx->symbols;
+    size_t found = 0;
+    uint32_t rounds = symtab_rounds(state);
+    for (uint32_t round = 0; round < rounds; round++)
+    {
+        for (uint32_t i = 0; i < state->count; i++)
+        {
+            found += symtab_lookup(table, state->names[i]) != NULL;
+        }
+    }
+    micro_sink = found;
+    return (size_t)rounds * state->count;
+}
+
+// Parses a generated program once; each run regenerates its JavaScript.
+static void setup_codegen(MicroState *state, int size)
+{
+    state->source = corpus_source(size, 1, &state->length);
+    bench_tokenize(state->ctx, state->source, state->length);
+    bench_parse(state->ctx);
+    sink_init_memory(&state->output);
+}
+
+static size_t run_codegen(MicroState *state)
+{
+    sink_reset(&state->output);
+    convert_to_javascript_with_main_call(state->ctx, &state->output);
+    return state->ctx->ast.count;
+}
+
+static const MicroBench benches[] = {
+    {"lex/identifiers", "byte", setup_lex, run_lex, 0},
+    {"lex/numbers", "byte", setup_lex, run_lex, 1},
+    {"lex/strings", "byte", setup_lex, run_lex, 2},
+    {"lex/comments", "byte", setup_lex, run_lex, 3},
+    {"lex/operators", "byte", setup_lex, run_lex, 4},
+    {"classify/keywords", "word", setup_classify, run_classify, 1},
+    {"classify/identifiers", "word", setup_classify, run_classify, 0},
+    {"symtab/declare/100", "name", setup_symtab, run_symtab_declare, 100},
+    {"symtab/declare/10k", "name", setup_symtab, run_symtab_declare, 10000},
+    {"symtab/declare/1M", "name", setup_symtab, run_symtab_declare, 1000000},
+    {"symtab/lookup/100", "name", setup_symtab_lookup, run_symtab_lookup, 100},
+    {"symtab/lookup/10k", "name", setup_symtab_lookup, run_symtab_lookup, 10000},
+    {"symtab/lookup/1M", "name", setup_symtab_lookup, run_symtab_lookup, 1000000},
+    {"codegen/1M", "node", setup_codegen, run_codegen, 1000000},
+};
+
+static MicroResult measure(const MicroBench *bench, int warmup, int samples)
+{
+    MicroState state = {c2js_context_new()};
+    c2js_set_trace_level(state.ctx, C2JS_TRACE_OFF);
+    bench->setup(&state, bench->arg);
+    for (int i = 0; i < warmup; i++)
+    {
+        bench->run(&state);
+    }
+    double *times = malloc(sizeof(double) * samples);
+    for (int i = 0; i < samples; i++)
+    {
+        double start = cpu_seconds();
+        size_t ops = bench->run(&state);
+        times[i] = (cpu_seconds() - start) / ops * 1e9;
+    }
+
+    MicroResult result;
+    snprintf(result.name, sizeof(result.name), "%s", bench->name);
+    result.median = median(times, samples);
+    result.min = times[0];
+    for (int i = 0; i < samples; i++)
+    {
+        times[i] = times[i] > result.median ? times[i] - result.median : result.median - times[i];
+    }
+    result.mad = median(times, samples);
+
+    free(times);
+    free(state.names);
+    arena_free(&state.tableArena);
+    if (state.output.data)
+    {
+        sink_close(&state.output);
+    }
+    free(state.source);
+    c2js_context_free(state.ctx);
+    return result;
+}
+
+// Reads a file written by --json; returns the number of results read.
+static int read_results(const char *path, MicroResult *results, int capacity)
+{
+    FILE *file = fopen(path, "r");
+    if (!file)
+    {
+        perror(path);
+        exit(2);
+    }
+    char line[512];
+    int count = 0;
+    while (count < capacity && fgets(line, sizeof(line), file))
+    {
+        MicroResult *result = &results[count];
+        if (sscanf(line, " {\"name\": \"%63[^\"]\", \"ns_per_op\": %lf, \"min\": %lf, \"mad\": %lf", result->name, &result->median,
+                   &result->min, &result->mad) == 4)
+        {
+            count++;
+        }
+    }
+    fclose(file);
+    return count;
+}
+
+static void write_results(const char *path, const MicroResult *results, int count, int samples, int warmup)
+{
+    FILE *file = fopen(path, "w");
+    if (!file)
+    {
+        perror(path);
+        exit(2);
+    }
+    fprintf(file, "{\"samples\": %d, \"warmup\": %d, \"results\": [\n", samples, warmup);
+    for (int i = 0; i < count; i++)
+    {
+        fprintf(file, "  {\"name\": \"%s\", \"ns_per_op\": %.4f, \"min\": %.4f, \"mad\": %.4f}%s\n", results[i].name, results[i].median,
+                results[i].min, results[i].mad, i + 1 < count ? "," : "");
+    }
+    fprintf(file, "]}\n");
+    fclose(file);
+}
+
+int main(int argc, char **argv)
+{
+    int samples = 15;
+    int warmup = 3;
+    double threshold = 10;
+    const char *filter = NULL;
+    const char *jsonPath = NULL;
+    const char *comparePath = NULL;
+    ScanLevel scanCap = SCAN_AVX2;
+    for (int i = 1; i < argc; i++)
+    {
+        if (i + 1 < argc && strcmp(argv[i], "--samples") == 0)
+        {
+            samples = atoi(argv[++i]);
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--warmup") == 0)
+        {
+            warmup = atoi(argv[++i]);
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--filter") == 0)
+        {
+            filter = argv[++i];
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--json") == 0)
+        {
+            jsonPath = argv[++i];
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--compare") == 0)
+        {
+            comparePath = argv[++i];
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--threshold") == 0)
+        {
+            threshold = atof(argv[++i]);
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--scan") == 0)
+        {
+            const char *name = argv[++i];
+            int level = SCAN_AVX2;
+            while (level >= 0 && strcmp(scan_level_names[level], name) != 0)
+            {
+                level--;
+            }
+            if (level < 0)
+            {
+                fprintf(stderr, "unknown scan level: %s\n", name);
+                return 2;
+            }
+            scanCap = level;
+        }
+        else
+        {
+            fprintf(stderr, "usage: micro_bench [--samples N] [--warmup N] [--filter TEXT]\n"
+                            "                   [--json FILE] [--compare FILE] [--threshold PERCENT]\n"
+                            "                   [--scan scalar|sse2|avx2]\n");
+            return 2;
+        }
+    }
+    if (samples < 1)
+    {
+        samples = 1;
+    }
+    printf("scan kernels: %s\n", scan_level_names[scan_set_level(scanCap)]);
+
+    enum { BENCH_COUNT = sizeof(benches) / sizeof(benches[0]) };
+    MicroResult baseline[BENCH_COUNT * 2];
+    int baselineCount = comparePath ? read_results(comparePath, baseline, BENCH_COUNT * 2) : 0;
+
+    MicroResult results[BENCH_COUNT];
+    int count = 0;
+    int regressions = 0;
+    printf("%-22s %-5s %10s %10s %8s%s\n", "benchmark", "op", "ns/op", "min", "mad", comparePath ? "    vs base" : "");
+    for (int i = 0; i < BENCH_COUNT; i++)
+    {
+        if (filter && !strstr(benches[i].name, filter))
+        {
+            continue;
+        }
+        MicroResult *result = &results[count++];
+        *result = measure(&benches[i], warmup, samples);
+        printf("%-22s %-5s %10.3f %10.3f %8.3f", result->name, benches[i].unit, result->median, result->min, result->mad);
+        for (int b = 0; b < baselineCount; b++)
+        {
+            if (strcmp(baseline[b].name, result->name) == 0)
+            {
+                double change = (result->median / baseline[b].median - 1) * 100;
+                bool regressed = change > threshold;
+                regressions += regressed;
+                printf(" %+9.1f%%%s", change, regressed ? "  REGRESSION" : "");
+                break;
+            }
+        }
+        printf("\n");
+        fflush(stdout);
+    }
+
+    if (jsonPath)
+    {
+        write_results(jsonPath, results, count, samples, warmup);
+    }
+    if (comparePath)
+    {
+        if (regressions)
+        {
+            printf("FAIL: %d benchmark%s more than %.1f%% slower than %s\n", regressions, regressions == 1 ? "" : "s", threshold, comparePath);
+            return 1;
+        }
+        printf("OK: no benchmark more than %.1f%% slower than %s\n", threshold, comparePath);
+    }
+    return 0;
+}
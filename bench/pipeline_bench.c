@@ -0,0 +1,197 @@
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "../clock.h"
+#include "../libc2js.h"
+#include "corpus.h"
+#include "stats.h"
+
+// End-to-end translation time over generated corpora (see corpus.h). Each
+// size runs in its own child process, which generates the input in memory
+// and translates it repeatedly through c2js_translate_buffer(); the parent
+// reports the median and 99th percentile time, throughput at the median,
+// and the child's peak RSS (input, output and translator state together).
+// Usage: pipeline_bench [--seed N] [--runs N] [--threads N] [--stream] [SIZE...]
+//        SIZE in bytes with an optional K, M or G suffix (powers of 1000);
+//        default 1K 10K 100K 1M 10M. Without --runs, each size gets as many
+//        runs as fit in about 2e8 input bytes, between 5 and 101. --threads
+//        sets c2js_set_threads() (default 1). --stream translates through
+//        c2js_translate_stream() from a temporary file instead, so the input
+//        is not held in memory while it is translated.
+
+typedef struct
+{
+    size_t bytes;
+    size_t tokens;
+    int runs;
+    double median;
+    double p99;
+} SizeResult;
+
+static size_t parse_size(const char *text)
+{
+    char *suffix;
+    double size = strtod(text, &suffix);
+    double scale = *suffix == 'K' || *suffix == 'k' ? 1e3 : *suffix == 'M' || *suffix == 'm' ? 1e6 : *suffix == 'G' || *suffix == 'g' ? 1e9 : 1;
+    return (size_t)(size * scale);
+}
+
+// Writes the corpus to an unlinked temporary file and frees it.
+static int corpus_file(OutputSink *input)
+{
+    FILE *file = tmpfile();
+    if (!file || fwrite(input->data, 1, input->length, file) != input->length || fflush(file) != 0)
+    {
+        perror("Failed to write the corpus");
+        exit(EXIT_FAILURE);
+    }
+    free(input->data);
+    input->data = NULL;
+    input->capacity = 0;
+    return dup(fileno(file));
+}
+
+// Runs in the child: translates runs times and fills result.
+static bool measure(size_t size, uint64_t seed, int runs, int threads, bool stream, SizeResult *result)
+{
+    OutputSink input;
+    sink_init_memory(&input);
+    corpus_generate(&input, size, seed);
+    size_t inputLength = input.length;
+    int fd = stream ? corpus_file(&input) : -1;
+
+    C2jsContext *ctx = c2js_context_new();
+    c2js_set_trace_level(ctx, C2JS_TRACE_ERROR);
+    c2js_set_log(ctx, stderr);
+    c2js_set_threads(ctx, threads);
+    OutputSink output;
+    sink_init_memory(&output);
+
+    double *times = malloc(sizeof(double) * runs);
+    bool ok = true;
+    for (int run = 0; run < runs && ok; run++)
+    {
+        sink_reset(&output);
+        double start = now_seconds();
+        if (stream)
+        {
+            lseek(fd, 0, SEEK_SET);
+            ok = c2js_translate_stream(ctx, fd, &output) == C2JS_OK;
+        }
+        else
+        {
+            ok = c2js_translate_buffer(ctx, input.data, input.length, &output) == C2JS_OK;
+        }
+        times[run] = now_seconds() - start;
+    }
+    if (ok)
+    {
+        sort_doubles(times, runs);
+        *result = (SizeResult){inputLength, c2js_last_stats(ctx)->tokens, runs, percentile(times, runs, 0.5), percentile(times, runs, 0.99)};
+    }
+
+    free(times);
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+    sink_close(&output);
+    c2js_context_free(ctx);
+    sink_close(&input);
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t seed = 1;
+    int fixedRuns = 0;
+    int threads = 1;
+    bool stream = false;
+    size_t sizes[64];
+    int sizeCount = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+        {
+            seed = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc)
+        {
+            fixedRuns = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--stream") == 0)
+        {
+            stream = true;
+        }
+        else if (sizeCount < 64 && parse_size(argv[i]) > 0)
+        {
+            sizes[sizeCount++] = parse_size(argv[i]);
+        }
+        else
+        {
+            fprintf(stderr, "usage: pipeline_bench [--seed N] [--runs N] [--threads N] [--stream] [SIZE...]\n");
+            return 2;
+        }
+    }
+    if (sizeCount == 0)
+    {
+        static const size_t defaults[] = {1000, 10000, 100000, 1000000, 10000000};
+        memcpy(sizes, defaults, sizeof(defaults));
+        sizeCount = 5;
+    }
+
+    printf("seed %llu, %d thread%s%s\n", (unsigned long long)seed, threads, threads == 1 ? "" : "s", stream ? ", streaming" : "");
+    printf("%12s %10s %5s %12s %12s %10s %12s %10s\n", "bytes", "tokens", "runs", "median ms", "p99 ms", "MB/s", "tokens/s", "peak RSS MB");
+    fflush(stdout);
+    int status = 0;
+    for (int i = 0; i < sizeCount; i++)
+    {
+        int runs = fixedRuns > 0 ? fixedRuns : (int)(2e8 / sizes[i]);
+        runs = fixedRuns > 0 ? runs : runs < 5 ? 5 : runs > 101 ? 101 : runs;
+
+        // A fresh process per size, so its peak RSS belongs to that size.
+        int fds[2];
+        if (pipe(fds) != 0)
+        {
+            perror("pipe");
+            return 1;
+        }
+        pid_t child = fork();
+        if (child == 0)
+        {
+            close(fds[0]);
+            SizeResult result;
+            bool ok = measure(sizes[i], seed, runs, threads, stream, &result);
+            if (ok)
+            {
+                ok = write(fds[1], &result, sizeof(result)) == sizeof(result);
+            }
+            _exit(ok ? 0 : 1);
+        }
+        close(fds[1]);
+        SizeResult result;
+        bool received = child > 0 && read(fds[0], &result, sizeof(result)) == sizeof(result);
+        close(fds[0]);
+        int childStatus = 0;
+        struct rusage usage = {0};
+        if (child > 0)
+        {
+            wait4(child, &childStatus, 0, &usage);
+        }
+        if (!received || !WIFEXITED(childStatus) || WEXITSTATUS(childStatus) != 0)
+        {
+            printf("%12zu FAILED: generated input did not translate\n", sizes[i]);
+            status = 1;
+            continue;
+        }
+        printf("%12zu %10zu %5d %12.3f %12.3f %10.2f %12.0f %10.1f\n", result.bytes, result.tokens, result.runs,
+               result.median * 1e3, result.p99 * 1e3, result.bytes / result.median / 1e6, result.tokens / result.median,
+               usage.ru_maxrss / 1024.0);
+        fflush(stdout);
+    }
+    return status;
+}
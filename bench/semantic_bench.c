@@ -0,0 +1,98 @@
+#include "../libc2js.c"
+#include "bench.h"
+
+// Semantic analysis time against the number of declarations. The input is
+// one function holding a single declaration list of n names, each
+// initialised from the previous one, followed by n declaration statements
+// that each use two earlier names.
+// Usage: semantic_bench [max_declarations]   (default 100,000 per list)
+//        semantic_bench --check              analyse 20k and 200k declarations
+//                                            (100k in one list) and fail unless
+//                                            time grows near-linearly
+
+static char *make_source(int declarations, size_t *length)
+{
+    size_t capacity = (size_t)declarations * 64 + 64;
+    char *source = malloc(capacity);
+    size_t used = sprintf(source, "int main(){\n    int v0 = 0");
+    for (int i = 1; i < declarations; i++)
+    {
+        used += sprintf(source + used, ", v%d = v%d", i, i - 1);
+    }
+    used += sprintf(source + used, ";\n    int w0 = v0;\n");
+    for (int i = 1; i < declarations; i++)
+    {
+        used += sprintf(source + used, "    int w%d = v%d+w%d;\n", i, i, i - 1);
+    }
+    used += sprintf(source + used, "}\n");
+    *length = used;
+    return source;
+}
+
+// Returns the best of five semantic passes over the same parse, in seconds.
+static double run(C2jsContext *ctx, int declarations)
+{
+    size_t length;
+    char *source = make_source(declarations, &length);
+    bench_tokenize(ctx, source, length);
+    double start = now_seconds();
+    bench_parse(ctx);
+    double parseSeconds = now_seconds() - start;
+
+    double best = 0;
+    int errors = 0;
+    for (int repeat = 0; repeat < 5; repeat++)
+    {
+        symtab_init(&ctx->symbols, &ctx->arena);
+        start = now_seconds();
+        errors = semantic_analysis(ctx);
+        double elapsed = now_seconds() - start;
+        best = repeat == 0 || elapsed < best ? elapsed : best;
+    }
+    if (errors)
+    {
+        printf("FAIL: %d semantic errors in generated input\n", errors);
+        exit(1);
+    }
+
+    int total = declarations * 2;
+    printf("%12d %12d %10.4f %10.4f %10.1f\n", total, ctx->ast.count, parseSeconds, best, best / total * 1e9);
+    free(source);
+    return best / total;
+}
+
+int main(int argc, char **argv)
+{
+    bool check = argc > 1 && strcmp(argv[1], "--check") == 0;
+    int maxDeclarations = argc > 1 && !check ? atoi(argv[1]) : 100000;
+
+    C2jsContext *ctx = c2js_context_new();
+    c2js_set_trace_level(ctx, C2JS_TRACE_OFF);
+
+    printf("%12s %12s %10s %10s %10s\n", "declarations", "nodes", "parse s", "semantic s", "ns/decl");
+    int status = 0;
+    if (!check)
+    {
+        for (int declarations = 1000; declarations <= maxDeclarations; declarations *= 10)
+        {
+            run(ctx, declarations);
+        }
+    }
+    else
+    {
+        double small = run(ctx, 10000);
+        double large = run(ctx, 100000);
+        if (large > small * 2)
+        {
+            printf("FAIL: 10x the declarations took %.1fx longer per declaration\n", large / small);
+            status = 1;
+        }
+        else
+        {
+            printf("OK: semantic analysis time grows linearly with declarations\n");
+        }
+    }
+
+    c2js_context_free(ctx);
+    return status;
+}
@@ -0,0 +1,34 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdlib.h>
+
+// Order statistics over timing samples.
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void sort_doubles(double *values, int count)
+{
+    qsort(values, count, sizeof(double), compare_doubles);
+}
+
+// Nearest-rank percentile of sorted values.
+static double percentile(const double *sorted, int count, double fraction)
+{
+    int rank = (int)(fraction * count + 0.999999);
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+// Sorts values and returns their median.
+static double median(double *values, int count)
+{
+    sort_doubles(values, count);
+    return count % 2 ? values[count / 2] : (values[count / 2 - 1] + values[count / 2]) / 2;
+}
+
+#endif
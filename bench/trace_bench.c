@@ -0,0 +1,114 @@
+#include "../libc2js.c"
+#include "bench.h"
+#include "corpus.h"
+
+// Cost of the parser's trace statements. Generated input (see corpus.h) is
+// lexed once, then parse() is timed at each run-time trace level with the
+// log sent to /dev/null. The Makefile builds this file three times:
+// trace_bench with every level compiled in, trace_bench_release with the
+// NDEBUG gating of release builds (errors only), and trace_bench_off with
+// C2JS_TRACE_MAX set to C2JS_TRACE_OFF, so no trace statement exists at all.
+// Usage: trace_bench [source_bytes]      (default 20 MB)
+//        trace_bench --check             fail unless a release build with
+//                                        tracing disabled parses within 5%
+//                                        of trace_bench_off
+//        trace_bench --baseline          print only the ns/token at level off
+//                                        (used by --check)
+
+// Returns the best of several parses at the given level, in ns per token.
+static double time_parse(C2jsContext *ctx, C2jsTraceLevel level, int repeats)
+{
+    c2js_set_trace_level(ctx, level);
+    double best = 0;
+    for (int repeat = 0; repeat < repeats; repeat++)
+    {
+        // Reuse the node array; the arena only grows between resets.
+        ctx->ast.count = 0;
+        double start = cpu_seconds();
+        bench_parse(ctx);
+        double elapsed = cpu_seconds() - start;
+        best = repeat == 0 || elapsed < best ? elapsed : best;
+    }
+    return best / ctx->tokens.count * 1e9;
+}
+
+// Runs program + suffix with --baseline and returns its ns/token.
+static double baseline_run(const char *program, const char *suffix)
+{
+    char command[4096];
+    snprintf(command, sizeof(command), "%s%s --baseline", program, suffix);
+    FILE *child = popen(command, "r");
+    double nsPerToken;
+    if (!child || fscanf(child, "%lf", &nsPerToken) != 1 || pclose(child) != 0)
+    {
+        printf("FAIL: could not run %s\n", command);
+        exit(1);
+    }
+    return nsPerToken;
+}
+
+int main(int argc, char **argv)
+{
+    bool check = argc > 1 && strcmp(argv[1], "--check") == 0;
+    bool baseline = argc > 1 && strcmp(argv[1], "--baseline") == 0;
+    size_t size = argc > 1 && !check && !baseline ? strtoull(argv[1], NULL, 10) : 20u * 1000 * 1000;
+
+    size_t length;
+    char *source = corpus_source(size, 1, &length);
+
+    C2jsContext *ctx = c2js_context_new();
+    FILE *devnull = fopen("/dev/null", "w");
+    c2js_set_log(ctx, devnull);
+    bench_tokenize(ctx, source, length);
+
+    int status = 0;
+    if (baseline)
+    {
+        printf("%.3f\n", time_parse(ctx, C2JS_TRACE_OFF, 7));
+    }
+    else if (check)
+    {
+        // Timings vary between processes more than within one (memory
+        // layout), so the builds run as fresh processes, alternately, and
+        // the fastest run of each is compared.
+        double compiledOut = 0;
+        double release = 0;
+        double debug = 0;
+        for (int round = 0; round < 7; round++)
+        {
+            double off = baseline_run(argv[0], "_off");
+            double disabled = baseline_run(argv[0], "_release");
+            double all = baseline_run(argv[0], "");
+            compiledOut = round == 0 || off < compiledOut ? off : compiledOut;
+            release = round == 0 || disabled < release ? disabled : release;
+            debug = round == 0 || all < debug ? all : debug;
+        }
+        printf("parse, tracing compiled out:              %8.2f ns/token\n", compiledOut);
+        printf("parse, release build, tracing disabled:   %8.2f ns/token\n", release);
+        printf("parse, all levels compiled in, disabled:  %8.2f ns/token\n", debug);
+        if (release > compiledOut * 1.05)
+        {
+            printf("FAIL: disabled tracing costs %.1f%% in release builds\n", (release / compiledOut - 1) * 100);
+            status = 1;
+        }
+        else
+        {
+            printf("OK: disabled tracing is within noise of no tracing\n");
+        }
+    }
+    else
+    {
+        static const char *names[] = {"off", "error", "info", "trace"};
+        printf("%d tokens, tracing compiled in up to level %d\n", ctx->tokens.count, C2JS_TRACE_MAX);
+        printf("%-8s %12s\n", "level", "ns/token");
+        for (int level = C2JS_TRACE_OFF; level <= C2JS_TRACE_TRACE; level++)
+        {
+            printf("%-8s %12.2f\n", names[level], time_parse(ctx, level, 3));
+        }
+    }
+
+    fclose(devnull);
+    c2js_context_free(ctx);
+    free(source);
+    return status;
+}
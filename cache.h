@@ -0,0 +1,309 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "arena.h"
+
+// Content-addressed translation cache on disk. Each entry is one file named
+// by a 128-bit hash of what produced it, under one of 256 subdirectories:
+// <dir>/ab/ab01...ef. An entry is written to a temporary file in <dir> and
+// renamed into place, so readers in any thread or process see a whole entry
+// or none, and concurrent writers of the same key simply replace each other
+// with identical bytes. A hit refreshes the entry's mtime, and trimming
+// deletes the entries with the oldest mtimes until the total size is under
+// the cap, so eviction is least-recently-used across every process sharing
+// the directory.
+
+// Part of every key, with the hash of the translator that c2js_cache_open()
+// takes (see translator_version() in libc2js.c), so that changes to the
+// lexer tables or to the translator's sources retire old entries by
+// themselves. Bump it when the entry layout changes.
+#define CACHE_FORMAT 2
+
+#define CACHE_MAGIC "C2JSC001"
+
+typedef struct
+{
+    uint64_t high;
+    uint64_t low;
+} CacheKey;
+
+typedef struct
+{
+    char magic[8];
+    CacheKey key;
+    double cost;     // seconds it took to produce the entry
+    uint64_t length; // bytes of output that follow
+} CacheHeader;
+
+struct C2jsCache
+{
+    char *dir;
+    size_t maxBytes;
+    CacheKey version; // the translator that reads and writes the entries
+    atomic_size_t unTrimmed; // bytes written since the last trim
+    atomic_uint tempCounter;
+    pthread_mutex_t trimLock;
+};
+
+static inline uint64_t cache_rotate(uint64_t x, int bits)
+{
+    return x << bits | x >> (64 - bits);
+}
+
+static inline uint64_t cache_finish(uint64_t x)
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+// Two independent multiply-rotate lanes over 8-byte words: several GB/s,
+// which keeps hashing negligible next to translation.
+static CacheKey cache_key(const char *data, size_t length, CacheKey seed)
+{
+    uint64_t high = seed.high ^ 0x9E3779B97F4A7C15ull;
+    uint64_t low = seed.low ^ 0xC2B2AE3D27D4EB4Full;
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        high = cache_rotate((high ^ word) * 0x87c37b91114253d5ull, 31);
+        low = cache_rotate((low ^ word) * 0x4cf5ad432745937full, 29);
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, data + i, length - i);
+    high = cache_finish(high ^ tail ^ length);
+    low = cache_finish(low ^ cache_rotate(tail, 32) ^ high);
+    return (CacheKey){high, low};
+}
+
+// The seed of one kind of key (0 for functions, 1 for whole files).
+static CacheKey cache_seed(const struct C2jsCache *cache, uint64_t kind)
+{
+    return (CacheKey){cache->version.high, cache->version.low ^ kind};
+}
+
+// <dir>/ab/ab...: the first byte of the key names the subdirectory.
+static void cache_entry_path(const struct C2jsCache *cache, CacheKey key, char *path, size_t size)
+{
+    snprintf(path, size, "%s/%02x/%016llx%016llx", cache->dir, (unsigned)(key.high >> 56), (unsigned long long)key.high,
+             (unsigned long long)key.low);
+}
+
+// Reads the entry for key into the arena. Returns false on a miss or a
+// damaged entry.
+static bool cache_get(struct C2jsCache *cache, CacheKey key, Arena *arena, const char **data, size_t *length, double *cost)
+{
+    char path[4096];
+    cache_entry_path(cache, key, path, sizeof(path));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct stat st;
+    CacheHeader header;
+    bool found = fstat(fd, &st) == 0 && read(fd, &header, sizeof(header)) == sizeof(header) &&
+                 memcmp(header.magic, CACHE_MAGIC, 8) == 0 && header.key.high == key.high && header.key.low == key.low &&
+                 header.length == (uint64_t)st.st_size - sizeof(header);
+    if (found)
+    {
+        char *bytes = arena_alloc(arena, header.length + 1);
+        size_t done = 0;
+        while (done < header.length)
+        {
+            ssize_t count = read(fd, bytes + done, header.length - done);
+            if (count <= 0)
+            {
+                break;
+            }
+            done += count;
+        }
+        found = done == header.length;
+        *data = bytes;
+        *length = header.length;
+        *cost = header.cost;
+    }
+    close(fd);
+    if (found)
+    {
+        // Marks the entry as recently used for trimming.
+        utimensat(AT_FDCWD, path, NULL, 0);
+    }
+    return found;
+}
+
+static void cache_trim(struct C2jsCache *cache);
+
+static bool cache_write_all(int fd, const void *data, size_t length)
+{
+    const char *bytes = data;
+    while (length > 0)
+    {
+        ssize_t count = write(fd, bytes, length);
+        if (count < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (count <= 0)
+        {
+            return false;
+        }
+        bytes += count;
+        length -= count;
+    }
+    return true;
+}
+
+// Stores data under key. Failures are ignored: the cache is an optimisation.
+static void cache_put(struct C2jsCache *cache, CacheKey key, const char *data, size_t length, double cost)
+{
+    char temp[4096];
+    snprintf(temp, sizeof(temp), "%s/.tmp-%ld-%u", cache->dir, (long)getpid(), atomic_fetch_add(&cache->tempCounter, 1));
+    int fd = open(temp, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+    if (fd < 0)
+    {
+        return;
+    }
+    CacheHeader header = {.key = key, .cost = cost, .length = length};
+    memcpy(header.magic, CACHE_MAGIC, 8);
+    bool written = cache_write_all(fd, &header, sizeof(header)) && cache_write_all(fd, data, length);
+    written = close(fd) == 0 && written;
+
+    char path[4096];
+    cache_entry_path(cache, key, path, sizeof(path));
+    bool stored = written && rename(temp, path) == 0;
+    if (written && !stored && errno == ENOENT)
+    {
+        // First entry in this subdirectory.
+        *strrchr(path, '/') = '\0';
+        mkdir(path, 0777);
+        cache_entry_path(cache, key, path, sizeof(path));
+        stored = rename(temp, path) == 0;
+    }
+    if (!stored)
+    {
+        unlink(temp);
+        return;
+    }
+
+    // Trim as the cache grows, not only at close, so a long batch stays
+    // near the cap.
+    size_t unTrimmed = atomic_fetch_add(&cache->unTrimmed, sizeof(header) + length) + sizeof(header) + length;
+    if (unTrimmed > cache->maxBytes / 8)
+    {
+        cache_trim(cache);
+    }
+}
+
+typedef struct
+{
+    char *path;
+    time_t mtime;
+    off_t size;
+} CacheFile;
+
+static int compare_cache_files(const void *a, const void *b)
+{
+    time_t x = ((const CacheFile *)a)->mtime;
+    time_t y = ((const CacheFile *)b)->mtime;
+    return x < y ? -1 : x > y;
+}
+
+// Deletes least recently used entries until the cache fits in maxBytes,
+// and temporary files abandoned by writers that died an hour or more ago.
+static void cache_trim(struct C2jsCache *cache)
+{
+    if (pthread_mutex_trylock(&cache->trimLock) != 0)
+    {
+        return; // another thread is already trimming
+    }
+    atomic_store(&cache->unTrimmed, 0);
+
+    CacheFile *files = NULL;
+    size_t count = 0;
+    size_t capacity = 0;
+    size_t total = 0;
+    time_t now = time(NULL);
+    char path[4096];
+    for (int sub = -1; sub < 256; sub++)
+    {
+        // -1 is the top directory, which holds only temporary files.
+        if (sub < 0)
+        {
+            snprintf(path, sizeof(path), "%s", cache->dir);
+        }
+        else
+        {
+            snprintf(path, sizeof(path), "%s/%02x", cache->dir, sub);
+        }
+        DIR *dir = opendir(path);
+        if (!dir)
+        {
+            continue;
+        }
+        size_t dirLength = strlen(path);
+        for (struct dirent *entry = readdir(dir); entry; entry = readdir(dir))
+        {
+            bool temporary = strncmp(entry->d_name, ".tmp-", 5) == 0;
+            if (entry->d_name[0] == '.' && !temporary)
+            {
+                continue;
+            }
+            snprintf(path + dirLength, sizeof(path) - dirLength, "/%s", entry->d_name);
+            struct stat st;
+            if (lstat(path, &st) != 0 || !S_ISREG(st.st_mode))
+            {
+                continue;
+            }
+            if (temporary)
+            {
+                if (now - st.st_mtime > 3600)
+                {
+                    unlink(path);
+                }
+                continue;
+            }
+            if (count == capacity)
+            {
+                capacity = capacity ? capacity * 2 : 1024;
+                files = realloc(files, sizeof(CacheFile) * capacity);
+            }
+            files[count++] = (CacheFile){strdup(path), st.st_mtime, st.st_size};
+            total += st.st_size;
+        }
+        path[dirLength] = '\0';
+        closedir(dir);
+    }
+
+    qsort(files, count, sizeof(CacheFile), compare_cache_files);
+    for (size_t i = 0; i < count; i++)
+    {
+        if (total > cache->maxBytes && (unlink(files[i].path) == 0 || errno == ENOENT))
+        {
+            total -= files[i].size;
+        }
+        free(files[i].path);
+    }
+    free(files);
+    pthread_mutex_unlock(&cache->trimLock);
+}
+
+#endif
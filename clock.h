@@ -0,0 +1,22 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <time.h>
+
+// Seconds on the monotonic clock, for timing phases and runs.
+static inline double now_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// CPU time of the process, which time spent descheduled does not skew.
+static inline double cpu_seconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+#endif
@@ -0,0 +1,182 @@
+#ifndef INTERN_H
+#define INTERN_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+// Maps each distinct lexeme to a dense 32-bit ID. Lexemes are not copied: the
+// table points at the first occurrence, so the text passed to intern() must
+// stay alive and unchanged until the next interner_init(), and intern_text()
+// is not NUL-terminated; print it with intern_length(). IDs below KW_COUNT
+// are the reserved words of keywords.h in KeywordId order, so keyword tests
+// on tokens are integer comparisons.
+// All storage comes from the arena; call interner_init() again after a reset.
+// Include after keywords.h.
+
+typedef struct
+{
+    uint32_t *slots; // ID + 1, or 0 for an empty slot
+    uint32_t slotCount;
+    const char **texts;
+    uint32_t *lengths;
+    uint32_t *hashes;
+    uint32_t count;
+    uint32_t capacity;
+    Arena *arena;
+} Interner;
+
+#define INTERN_NONE UINT32_MAX
+
+// FNV-1a. Lexemes of 16 bytes or more, mostly string literals, are taken 8
+// bytes at a time so they cost one multiply per word rather than per byte;
+// the final mix brings the high bits of the last words down to the slot bits.
+static uint32_t intern_hash(const char *text, size_t length)
+{
+    if (length < 16)
+    {
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < length; i++)
+        {
+            hash = (hash ^ (unsigned char)text[i]) * 16777619u;
+        }
+        return hash;
+    }
+    uint64_t hash = 14695981039346656037ull;
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, text + i, 8);
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+    for (; i < length; i++)
+    {
+        hash = (hash ^ (unsigned char)text[i]) * 1099511628211ull;
+    }
+    hash ^= hash >> 32;
+    hash *= 0xd6e8feb86659fd93ull;
+    return (uint32_t)(hash >> 32);
+}
+
+static void *intern_regrow(Arena *arena, const void *old, size_t oldSize, size_t newSize)
+{
+    void *memory = arena_alloc(arena, newSize);
+    if (old)
+    {
+        memcpy(memory, old, oldSize);
+    }
+    return memory;
+}
+
+static void intern_grow_arrays(Interner *interner, uint32_t capacity)
+{
+    Arena *arena = interner->arena;
+    interner->texts = intern_regrow(arena, interner->texts, sizeof(char *) * interner->count, sizeof(char *) * capacity);
+    interner->lengths = intern_regrow(arena, interner->lengths, sizeof(uint32_t) * interner->count, sizeof(uint32_t) * capacity);
+    interner->hashes = intern_regrow(arena, interner->hashes, sizeof(uint32_t) * interner->count, sizeof(uint32_t) * capacity);
+    interner->capacity = capacity;
+}
+
+static void intern_grow_slots(Interner *interner)
+{
+    uint32_t slotCount = interner->slotCount ? interner->slotCount * 2 : 1024;
+    uint32_t *slots = arena_alloc(interner->arena, sizeof(uint32_t) * slotCount);
+    memset(slots, 0, sizeof(uint32_t) * slotCount);
+    for (uint32_t id = 0; id < interner->count; id++)
+    {
+        uint32_t slot = interner->hashes[id] & (slotCount - 1);
+        while (slots[slot])
+        {
+            slot = (slot + 1) & (slotCount - 1);
+        }
+        slots[slot] = id + 1;
+    }
+    interner->slots = slots;
+    interner->slotCount = slotCount;
+}
+
+// The slot holding text's ID, or the empty slot where it would go.
+static uint32_t intern_slot(const Interner *interner, const char *text, size_t length, uint32_t hash)
+{
+    uint32_t slot = hash & (interner->slotCount - 1);
+    while (interner->slots[slot])
+    {
+        uint32_t id = interner->slots[slot] - 1;
+        if (interner->hashes[id] == hash && interner->lengths[id] == length &&
+            memcmp(interner->texts[id], text, length) == 0)
+        {
+            break;
+        }
+        slot = (slot + 1) & (interner->slotCount - 1);
+    }
+    return slot;
+}
+
+// The ID of text if it has been interned, or INTERN_NONE.
+static uint32_t intern_find(const Interner *interner, const char *text, size_t length)
+{
+    return interner->slots[intern_slot(interner, text, length, intern_hash(text, length))] - 1;
+}
+
+static uint32_t intern(Interner *interner, const char *text, size_t length)
+{
+    uint32_t hash = intern_hash(text, length);
+    uint32_t slot = intern_slot(interner, text, length, hash);
+    if (interner->slots[slot])
+    {
+        return interner->slots[slot] - 1;
+    }
+
+    if (interner->count == interner->capacity)
+    {
+        intern_grow_arrays(interner, interner->capacity * 2);
+    }
+    uint32_t id = interner->count++;
+    interner->texts[id] = text;
+    interner->lengths[id] = length;
+    interner->hashes[id] = hash;
+    interner->slots[slot] = id + 1;
+
+    if (interner->count * 2 > interner->slotCount)
+    {
+        intern_grow_slots(interner);
+    }
+    return id;
+}
+
+static const char *intern_text(const Interner *interner, uint32_t id)
+{
+    return interner->texts[id];
+}
+
+static int intern_length(const Interner *interner, uint32_t id)
+{
+    return interner->lengths[id];
+}
+
+static void interner_init(Interner *interner, Arena *arena)
+{
+    memset(interner, 0, sizeof(Interner));
+    interner->arena = arena;
+    intern_grow_arrays(interner, 1024);
+    intern_grow_slots(interner);
+
+    // Seed the reserved words so that their IDs equal their KeywordId.
+    const char *reserved[KW_COUNT] = {""};
+    for (size_t slot = 0; slot < sizeof(keyword_table) / sizeof(keyword_table[0]); slot++)
+    {
+        if (keyword_table[slot].length)
+        {
+            reserved[keyword_table[slot].id] = keyword_table[slot].text;
+        }
+    }
+    for (int id = KW_NONE; id < KW_COUNT; id++)
+    {
+        intern(interner, reserved[id], strlen(reserved[id]));
+    }
+}
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef KEYWORDS_H
+#define KEYWORDS_H
+
+// Generated by tools/gen_keywords.c; do not edit.
+// Include after the TokenType enum.
+
+typedef enum
+{
+    KW_NONE,
+    KW_AUTO,
+    KW_BREAK,
+    KW_CASE,
+    KW_CONST,
+    KW_CONTINUE,
+    KW_DEFAULT,
+    KW_DO,
+    KW_ENUM,
+    KW_GOTO,
+    KW_RETURN,
+    KW_INT,
+    KW_CHAR,
+    KW_FLOAT,
+    KW_DOUBLE,
+    KW_VOID,
+    KW_LONG,
+    KW_SHORT,
+    KW_UNSIGNED,
+    KW_SIGNED,
+    KW_FOR,
+    KW_WHILE,
+    KW_IF,
+    KW_ELSE,
+    KW_SWITCH,
+    KW_STRCMP,
+    KW_STRCPY,
+    KW_SCANF,
+    KW_GETCHAR,
+    KW_GETCH,
+    KW_GETCHE,
+    KW_PRINTF,
+    KW_PUTCHAR,
+    KW_PUTS,
+    KW_COUNT
+} KeywordId;
+
+typedef struct
+{
+    unsigned char length;
+    char text[9];
+    TokenType type;
+    KeywordId id;
+} KeywordEntry;
+
+static const KeywordEntry keyword_table[128] = {
+    [0] = {8, "continue", KEYWORDS, KW_CONTINUE},
+    [6] = {6, "return", KEYWORDS, KW_RETURN},
+    [9] = {4, "char", DATA_TYPES, KW_CHAR},
+    [12] = {5, "const", KEYWORDS, KW_CONST},
+    [13] = {6, "signed", DATA_TYPES, KW_SIGNED},
+    [14] = {5, "scanf", INPUTS, KW_SCANF},
+    [15] = {6, "double", DATA_TYPES, KW_DOUBLE},
+    [17] = {6, "switch", CONDITIONAL, KW_SWITCH},
+    [21] = {2, "do", KEYWORDS, KW_DO},
+    [23] = {4, "long", DATA_TYPES, KW_LONG},
+    [25] = {6, "strcmp", FUNCTION, KW_STRCMP},
+    [28] = {5, "short", DATA_TYPES, KW_SHORT},
+    [30] = {4, "else", CONDITIONAL, KW_ELSE},
+    [31] = {7, "default", KEYWORDS, KW_DEFAULT},
+    [34] = {6, "strcpy", FUNCTION, KW_STRCPY},
+    [38] = {4, "enum", KEYWORDS, KW_ENUM},
+    [49] = {8, "unsigned", DATA_TYPES, KW_UNSIGNED},
+    [59] = {3, "for", LOOP, KW_FOR},
+    [62] = {4, "void", DATA_TYPES, KW_VOID},
+    [63] = {5, "float", DATA_TYPES, KW_FLOAT},
+    [66] = {6, "getche", INPUTS, KW_GETCHE},
+    [68] = {5, "getch", INPUTS, KW_GETCH},
+    [74] = {4, "goto", KEYWORDS, KW_GOTO},
+    [80] = {7, "getchar", INPUTS, KW_GETCHAR},
+    [81] = {5, "while", LOOP, KW_WHILE},
+    [92] = {6, "printf", OUTPUTS, KW_PRINTF},
+    [97] = {2, "if", CONDITIONAL, KW_IF},
+    [100] = {4, "auto", KEYWORDS, KW_AUTO},
+    [103] = {4, "puts", OUTPUTS, KW_PUTS},
+    [105] = {7, "putchar", OUTPUTS, KW_PUTCHAR},
+    [112] = {3, "int", DATA_TYPES, KW_INT},
+    [114] = {5, "break", KEYWORDS, KW_BREAK},
+    [124] = {4, "case", KEYWORDS, KW_CASE},
+};
+
+static inline unsigned keyword_slot(const char *text, size_t length)
+{
+    return (length * 1u + (unsigned char)text[0] * 17u + (unsigned char)text[length - 1]) & 127;
+}
+
+#endif
@@ -0,0 +1,297 @@
+#ifndef LEXER_H
+#define LEXER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include <stdbool.h>
+
+
+typedef enum
+{
+    DATA_TYPES,
+    ID,
+    OP,
+    KEYWORDS,
+    NUM,
+    STRING,
+    CHAR,
+    COMMENT,
+    PUNCTUATORS,
+    LPAREN,
+    RPAREN,
+    LBRACE,
+    RBRACE,
+    LBRACKET,
+    RBRACKET,
+    SEMICOLON,
+    COMMA,
+    COLON,
+    DOT,
+    PREPROCESSOR,
+    T_EOF, 
+    UNKNOWN,
+    LOOP,
+    CONDITIONAL,
+    FUNCTION,
+    INPUTS,
+    OUTPUTS,
+    ASSIGNMENT
+} TokenType;
+
+#include "keywords.h"
+#include "intern.h"
+#include "scan.h"
+#include "punctuators.h"
+
+#include "token_stream.h"
+#include "line_index.h"
+
+// A token is an (offset, length) slice of the source it was lexed from, so
+// lexing allocates nothing per token. Its id is the lexeme's intern ID, which
+// for reserved words equals their KeywordId. Every token but EOF takes at
+// least one byte and tokens are counted in an int, so a single input is
+// limited to TOKEN_MAX_SOURCE bytes.
+#define TOKEN_MAX_SOURCE ((size_t)INT_MAX - 1)
+
+// The synthetic EOF token is the only one without a source slice.
+static const char *token_text(const char *source, const TokenStream *tokens, int i)
+{
+    return tokens->types[i] == T_EOF ? "EOF" : source + tokens->offsets[i];
+}
+
+// Arguments for a "%.*s" conversion printing the text of token i.
+#define TOKEN_TEXT(source, tokens, i) (int)(tokens).lengths[i], token_text((source), &(tokens), (i))
+
+static const char *token_type_strings[] = {
+    "DATA_TYPES",
+    "ID",
+    "OP",
+    "KEYWORDS",
+    "NUM",
+    "STRING",
+    "CHAR",
+    "COMMENT",
+    "PUNCTUATORS",
+    "LPAREN",
+    "RPAREN",
+    "LBRACE",
+    "RBRACE",
+    "LBRACKET",
+    "RBRACKET",
+    "SEMICOLON",
+    "COMMA",
+    "COLON",
+    "DOT",
+    "PREPROCESSOR",
+    "T_EOF",
+    "UNKNOWN",
+    "LOOP",
+    "CONDITIONAL",
+    "FUNCTION",
+    "INPUTS",
+    "OUTPUTS",
+    "ASSIGNMENT"
+};
+
+// The token each punctuator of punctuators.h lexes as. Operators and
+// comparisons, "==" included, are OP; "=" and the compound assignments are
+// ASSIGNMENT.
+static const TokenType punct_types[PUNCT_COUNT] = {
+    [PUNCT_NONE] = UNKNOWN,
+    [PUNCT_LPAREN] = LPAREN,
+    [PUNCT_RPAREN] = RPAREN,
+    [PUNCT_LBRACE] = LBRACE,
+    [PUNCT_RBRACE] = RBRACE,
+    [PUNCT_LBRACKET] = LBRACKET,
+    [PUNCT_RBRACKET] = RBRACKET,
+    [PUNCT_SEMICOLON] = SEMICOLON,
+    [PUNCT_COMMA] = COMMA,
+    [PUNCT_COLON] = COLON,
+    [PUNCT_DOT] = DOT,
+    [PUNCT_QUESTION] = OP,
+    [PUNCT_ARROW] = OP,
+    [PUNCT_PLUS] = OP,
+    [PUNCT_MINUS] = OP,
+    [PUNCT_STAR] = OP,
+    [PUNCT_SLASH] = OP,
+    [PUNCT_PERCENT] = OP,
+    [PUNCT_INCREMENT] = OP,
+    [PUNCT_DECREMENT] = OP,
+    [PUNCT_EQUAL] = OP,
+    [PUNCT_NOT_EQUAL] = OP,
+    [PUNCT_LESS] = OP,
+    [PUNCT_GREATER] = OP,
+    [PUNCT_LESS_EQUAL] = OP,
+    [PUNCT_GREATER_EQUAL] = OP,
+    [PUNCT_AND] = OP,
+    [PUNCT_OR] = OP,
+    [PUNCT_NOT] = OP,
+    [PUNCT_AMPERSAND] = OP,
+    [PUNCT_PIPE] = OP,
+    [PUNCT_CARET] = OP,
+    [PUNCT_TILDE] = OP,
+    [PUNCT_SHIFT_LEFT] = OP,
+    [PUNCT_SHIFT_RIGHT] = OP,
+    [PUNCT_ASSIGN] = ASSIGNMENT,
+    [PUNCT_ADD_ASSIGN] = ASSIGNMENT,
+    [PUNCT_SUB_ASSIGN] = ASSIGNMENT,
+    [PUNCT_MUL_ASSIGN] = ASSIGNMENT,
+    [PUNCT_DIV_ASSIGN] = ASSIGNMENT,
+    [PUNCT_MOD_ASSIGN] = ASSIGNMENT,
+    [PUNCT_AND_ASSIGN] = ASSIGNMENT,
+    [PUNCT_OR_ASSIGN] = ASSIGNMENT,
+    [PUNCT_XOR_ASSIGN] = ASSIGNMENT,
+    [PUNCT_SHIFT_LEFT_ASSIGN] = ASSIGNMENT,
+    [PUNCT_SHIFT_RIGHT_ASSIGN] = ASSIGNMENT,
+};
+
+// One probe into the generated perfect hash decides whether a slice is reserved.
+static TokenType classify_identifier(const char *text, size_t length, KeywordId *keyword)
+{
+    const KeywordEntry *entry = &keyword_table[keyword_slot(text, length)];
+    if (entry->length == length && memcmp(entry->text, text, length) == 0)
+    {
+        *keyword = entry->id;
+        return entry->type;
+    }
+    *keyword = KW_NONE;
+    return ID;
+}
+
+static void push_lexeme(TokenStream *tokens, Interner *interner, const char *code, TokenType type, const char *text, size_t length)
+{
+    uint32_t id = intern(interner, text, length);
+    token_stream_push(tokens, type, text - code, length, id);
+}
+
+// Every scan below is bounded by end and each byte is visited a constant
+// number of times, so lexing is O(n) and never reads past the buffer. Runs
+// of blanks, word and digit characters, comments and quoted text are skipped
+// a block at a time by the kernels in scan.h. Each lexeme is dispatched on
+// one char_class lookup of its first byte, and punctuators are matched
+// longest first by the DFA in punctuators.h.
+//
+// With partial set, the source may continue past end, so a lexeme that
+// reaches end might be longer than what is there; lexing stops before it
+// and returns its start. Otherwise returns end. Inlined into both callers,
+// so tokenize() pays nothing for the check.
+__attribute__((always_inline))
+static inline const char *tokenize_run(Interner *interner, TokenStream *tokens, const char *code, const char *end, bool partial)
+{
+    const char *p = code;
+    while (p < end)
+    {
+        const char *start = p;
+        int count = tokens->count;
+        char c = *p;
+        switch (char_class[(unsigned char)c])
+        {
+        case CC_BLANK:
+            p = scan_blank_end(p, end);
+            break;
+        case CC_WORD:
+        {
+            p = scan_word_end(p, end);
+            KeywordId keyword;
+            TokenType type = classify_identifier(start, p - start, &keyword);
+            uint32_t id = keyword != KW_NONE ? keyword : intern(interner, start, p - start);
+            token_stream_push(tokens, type, start - code, p - start, id);
+            break;
+        }
+        case CC_DIGIT:
+            p = scan_digits_end(p, end);
+            push_lexeme(tokens, interner, code, NUM, start, p - start);
+            break;
+        case CC_QUOTE:
+        case CC_APOSTROPHE:
+            start = ++p;
+            p = scan_find(p, end, c);
+            push_lexeme(tokens, interner, code, c == '"' ? STRING : CHAR, start, p - start);
+            if (p < end)
+            {
+                p++;
+            }
+            break;
+        case CC_HASH:
+            p = scan_find(p, end, '\n');
+            push_lexeme(tokens, interner, code, PREPROCESSOR, start, p - start);
+            break;
+        case CC_OTHER:
+            p++;
+            push_lexeme(tokens, interner, code, UNKNOWN, start, 1);
+            break;
+        default:
+            if (c == '/' && p + 1 < end && p[1] == '/')
+            {
+                p = scan_find(p, end, '\n');
+            }
+            else if (c == '/' && p + 1 < end && p[1] == '*')
+            {
+                p = scan_comment_end(p + 2, end);
+                p = p < end ? p + 2 : end;
+            }
+            else if (c == '&' && p + 1 < end && isalpha((unsigned char)p[1]))
+            {
+                // Address-of in scanf arguments: keep the name up to the
+                // closing paren. Any other '&' is a punctuator.
+                start = ++p;
+                p = scan_find(p, end, ')');
+                push_lexeme(tokens, interner, code, ID, start, p - start);
+            }
+            else
+            {
+                size_t punctLength;
+                Punctuator punct = punct_munch(p, end, &punctLength);
+                p += punctLength;
+                push_lexeme(tokens, interner, code, punct_types[punct], start, punctLength);
+            }
+            break;
+        }
+        if (partial && p == end)
+        {
+            tokens->count = count;
+            return start;
+        }
+    }
+    return end;
+}
+
+// code need not be NUL-terminated, and must outlive the tokens and the
+// interner contents, which point into it. length must not exceed
+// TOKEN_MAX_SOURCE.
+static void tokenize(Interner *interner, TokenStream *tokens, const char *code, size_t length)
+{
+    token_stream_reset(tokens, length);
+    tokenize_run(interner, tokens, code, code + length, false);
+    token_stream_push(tokens, T_EOF, length, 3, intern(interner, "EOF", 3));
+}
+
+// Lexes the first length bytes of a source that continues past them. The
+// tokens stop before the last lexeme, or run of blanks, that reaches length,
+// and end with a T_EOF at the offset where lexing stopped.
+static void tokenize_partial(Interner *interner, TokenStream *tokens, const char *code, size_t length)
+{
+    token_stream_reset(tokens, length);
+    size_t stop = tokenize_run(interner, tokens, code, code + length, true) - code;
+    token_stream_push(tokens, T_EOF, stop, 3, intern(interner, "EOF", 3));
+}
+
+// Tokens come in source order, so the line of each is found by stepping
+// through lines' starts rather than searching them.
+static void print_tokens(FILE *out, const char *source, const TokenStream *tokens, const LineIndex *lines)
+{
+    uint32_t line = 1;
+    for (int i = 0; i < tokens->count; i++)
+    {
+        while (line < lines->count && lines->starts[line] <= tokens->offsets[i])
+        {
+            line++;
+        }
+        fprintf(out, "<%s, %.*s, %u>\n", token_type_strings[tokens->types[i]], TOKEN_TEXT(source, *tokens, i), line);
+    }
+}
+
+#endif
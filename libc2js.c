@@ -0,0 +1,2209 @@
+#include <setjmp.h>
+#include <stdarg.h>
+#include "libc2js.h"
+#include "lexer.h"
+#include "ast.h"
+#include "cache.h"
+#include "clock.h"
+#include "symtab.h"
+
+// A top-level function met while translating with a cache.
+typedef struct
+{
+    uint32_t node;   // its NODE_FUNCTION, or NODE_CACHED on a hit
+    CacheKey key;    // its text and what it can see (see cached_function())
+    bool hit;
+    const char *js;  // on a hit, the stored translation
+    size_t length;
+    double cost;     // seconds spent parsing, checking and emitting it
+} CacheUnit;
+
+// One part of a translation split across threads (see parse_parallel()).
+typedef struct
+{
+    C2jsContext *ctx;
+    int start; // first token
+    int end;   // one past the last token
+    size_t visibleNames; // top-level names declared before start
+    int semanticErrors;
+    bool failed; // a syntax error, or parsing did not stop at end
+    OutputSink output;
+    FILE *log; // what this phase logged, replayed in order afterwards
+    char *logText;
+    size_t logLength;
+} Shard;
+
+// The top-level names of a stream's translated windows (see
+// c2js_translate_stream()). It outlives the windows, so its interner holds
+// copies of the names rather than slices of the source.
+typedef struct
+{
+    Arena arena;
+    Interner interner;
+    SymbolTable symbols;
+} GlobalScope;
+
+// All state of one translation. Nothing in the pipeline is global, so any
+// number of contexts can translate concurrently.
+struct C2jsContext
+{
+    Arena arena;
+    Interner interner;
+    const char *source; // tokens and interned lexemes are slices of this
+    TokenStream tokenStore; // owned; tokens is a copy of it, or of the parent's on a shard
+    TokenStream tokens;
+    LineIndex lineStore; // owned; lines points at it, or at the parent's on a shard
+    LineIndex *lines;
+    int firstLine; // where source starts: 1, 1 except in a stream's window
+    int firstColumn;
+    int currentToken;
+    int parseEnd; // program() stops at this token
+    Ast ast;
+    SymbolTable symbols;
+    FILE *log;
+    C2jsTraceLevel traceLevel;
+    jmp_buf syntaxError;
+    int errorLine;
+    int errorColumn;
+    C2jsStats stats;
+    double translationStart;
+    double phaseStart;
+    C2jsCache *cache;
+    CacheUnit *units;
+    uint32_t unitCount;
+    uint32_t unitCapacity;
+    OutputSink cacheOutput; // the whole output, kept to be stored
+    int threads;
+    Shard *shards;
+    int shardCapacity;
+    uint32_t *topNames; // (name, type) intern ID pairs, in source order
+    size_t topNameCount;
+    size_t topNameCapacity;
+    GlobalScope *globals; // while streaming, the names of earlier windows
+};
+
+// Log statements above C2JS_TRACE_MAX compile to nothing. Release builds
+// (NDEBUG) keep only errors, so the parser's per-token tracing costs
+// nothing there; otherwise it costs one predictable branch while disabled.
+#ifndef C2JS_TRACE_MAX
+#ifdef NDEBUG
+#define C2JS_TRACE_MAX C2JS_TRACE_ERROR
+#else
+#define C2JS_TRACE_MAX C2JS_TRACE_TRACE
+#endif
+#endif
+
+#define tracing(ctx, level) ((level) <= C2JS_TRACE_MAX && __builtin_expect((level) <= (ctx)->traceLevel, 0))
+
+#define trace(ctx, level, ...)                     \
+    do                                             \
+    {                                              \
+        if (tracing(ctx, level))                   \
+        {                                          \
+            trace_printf((ctx)->log, __VA_ARGS__); \
+        }                                          \
+    } while (0)
+
+// Out of line and cold, so a disabled trace statement leaves only a
+// compare and a not-taken branch in the hot path.
+__attribute__((cold, noinline, format(printf, 2, 3)))
+static void trace_printf(FILE *log, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    vfprintf(log, format, args);
+    va_end(args);
+}
+
+static void match(C2jsContext *ctx, TokenType expected);
+static void program(C2jsContext *ctx);
+static uint32_t external_declaration(C2jsContext *ctx);
+static uint32_t function_definition(C2jsContext *ctx);
+static void parameter_list(C2jsContext *ctx, uint32_t function, uint32_t *last);
+static uint32_t parameter(C2jsContext *ctx);
+static uint32_t declaration(C2jsContext *ctx);
+static uint32_t statement(C2jsContext *ctx);
+static uint32_t block(C2jsContext *ctx);
+static uint32_t expression_statement(C2jsContext *ctx);
+static uint32_t return_statement(C2jsContext *ctx);
+static uint32_t expression(C2jsContext *ctx);
+static void term(C2jsContext *ctx, uint32_t expr, uint32_t *last);
+static void factor(C2jsContext *ctx, uint32_t expr, uint32_t *last);
+static void parse(C2jsContext *ctx);
+static uint32_t for_statement(C2jsContext *ctx);
+static uint32_t while_statement(C2jsContext *ctx);
+static uint32_t do_while_statement(C2jsContext *ctx);
+static uint32_t if_statement(C2jsContext *ctx);
+static uint32_t else_statement(C2jsContext *ctx);
+static uint32_t switch_statement(C2jsContext *ctx);
+static uint32_t case_statement(C2jsContext *ctx);
+static uint32_t default_statement(C2jsContext *ctx);
+static uint32_t outputStatement(C2jsContext *ctx);
+static uint32_t inputStatement(C2jsContext *ctx);
+static uint32_t dataTypeDeclaration(C2jsContext *ctx);
+static uint32_t functionCall(C2jsContext *ctx);
+static uint32_t loopStatement(C2jsContext *ctx);
+static uint32_t conditionalStatement(C2jsContext *ctx);
+static uint32_t cached_function(C2jsContext *ctx, CacheKey *scope);
+
+// The line index of the source, built on first use, so a translation that
+// reports no position never builds it. The EOF token's offset is the
+// source's length. Shards read their parent's, which parse_parallel() builds
+// before they start.
+static const LineIndex *source_lines(C2jsContext *ctx)
+{
+    if (ctx->lines->count == 0)
+    {
+        line_index_build(ctx->lines, ctx->source, ctx->tokens.offsets[ctx->tokens.count - 1]);
+    }
+    return ctx->lines;
+}
+
+// The line of token i, and its column in *column.
+static int token_position(C2jsContext *ctx, int i, int *column)
+{
+    int line = line_index_find(source_lines(ctx), ctx->tokens.offsets[i], column);
+    if (line == 1)
+    {
+        *column += ctx->firstColumn - 1;
+    }
+    return line + ctx->firstLine - 1;
+}
+
+static int token_line(C2jsContext *ctx, int i)
+{
+    int column;
+    return token_position(ctx, i, &column);
+}
+
+static int token_column(C2jsContext *ctx, int i)
+{
+    int column;
+    token_position(ctx, i, &column);
+    return column;
+}
+
+// Unwinds the recursive descent back to c2js_translate_buffer().
+static void syntax_error(C2jsContext *ctx)
+{
+    ctx->errorLine = token_position(ctx, ctx->currentToken, &ctx->errorColumn);
+    longjmp(ctx->syntaxError, 1);
+}
+
+// Creates a node for the current token.
+static uint32_t node_here(C2jsContext *ctx, NodeKind kind)
+{
+    return ast_node(&ctx->ast, kind, ctx->currentToken);
+}
+
+// Syntax Analysis
+// Each function consumes one construct and returns its tree, or AST_NONE
+// when there is nothing to record.
+
+static void parse(C2jsContext *ctx){
+    ctx->currentToken = 0;
+    ctx->parseEnd = ctx->tokens.count - 1;
+    ctx->ast.root = node_here(ctx, NODE_PROGRAM);
+    program(ctx);
+    if(ctx->tokens.types[ctx->currentToken] == T_EOF){
+        trace(ctx, C2JS_TRACE_INFO, "Parsing successful\n");
+    } else {
+        trace(ctx, C2JS_TRACE_ERROR, "Parsing failed\n");
+    }
+}
+
+static void program(C2jsContext *ctx){
+    uint32_t last = AST_NONE;
+    CacheKey scope = ctx->cache ? cache_seed(ctx->cache, 0) : (CacheKey){0};
+    while(ctx->currentToken < ctx->parseEnd){
+        int start = ctx->currentToken;
+        ast_append(&ctx->ast, ctx->ast.root, &last, ctx->cache ? cached_function(ctx, &scope) : external_declaration(ctx));
+        if(ctx->currentToken == start){
+            trace(ctx, C2JS_TRACE_ERROR, "Syntax error at line %d, column %d\n", token_line(ctx, start), token_column(ctx, start));
+            syntax_error(ctx);
+        }
+    }
+}
+
+// Returns the index just past the '}' that closes the body of the function
+// starting at token start, or -1 if its braces do not balance.
+static int function_end(C2jsContext *ctx, int start){
+    int i = start;
+    while(ctx->tokens.types[i] != LBRACE){
+        if(ctx->tokens.types[i] == T_EOF || ctx->tokens.types[i] == SEMICOLON){
+            return -1;
+        }
+        i++;
+    }
+    int depth = 0;
+    do{
+        if(ctx->tokens.types[i] == T_EOF){
+            return -1;
+        }
+        depth += ctx->tokens.types[i] == LBRACE;
+        depth -= ctx->tokens.types[i] == RBRACE;
+        i++;
+    }while(depth > 0);
+    return i;
+}
+
+// The source bytes from token start up to token end.
+static CacheKey hash_tokens(C2jsContext *ctx, int start, int end, CacheKey seed){
+    const char *text = ctx->source + ctx->tokens.offsets[start];
+    size_t length = ctx->tokens.offsets[end - 1] + ctx->tokens.lengths[end - 1] - ctx->tokens.offsets[start];
+    return cache_key(text, length, seed);
+}
+
+// external_declaration() for translations with a cache. Whether a function
+// translates, and to what, depends only on its own text and on the names
+// declared before it, so a function is keyed by its bytes and by scope: a
+// hash of the names of the functions before it and of the whole text of
+// every other top-level declaration. A hit is not parsed at all; it becomes
+// a NODE_CACHED leaf that declares the name and emits the stored output.
+static uint32_t cached_function(C2jsContext *ctx, CacheKey *scope){
+    int start = ctx->currentToken;
+    bool isFunction = ctx->tokens.types[start] == DATA_TYPES && ctx->tokens.types[start + 1] != T_EOF &&
+                      ctx->tokens.types[start + 2] == LPAREN;
+    if(!isFunction){
+        uint32_t node = external_declaration(ctx);
+        if(ctx->currentToken > start){
+            *scope = hash_tokens(ctx, start, ctx->currentToken, *scope);
+        }
+        return node;
+    }
+
+    if(ctx->unitCount == ctx->unitCapacity){
+        ctx->unitCapacity = ctx->unitCapacity ? ctx->unitCapacity * 2 : 64;
+        ctx->units = realloc(ctx->units, sizeof(CacheUnit) * ctx->unitCapacity);
+        if(!ctx->units){
+            perror("Failed to allocate cache units");
+            exit(EXIT_FAILURE);
+        }
+    }
+    CacheUnit *unit = &ctx->units[ctx->unitCount];
+    *unit = (CacheUnit){0};
+    double begin = now_seconds();
+    int end = function_end(ctx, start);
+    if(end > 0){
+        ctx->stats.cacheLookups++;
+        unit->key = hash_tokens(ctx, start, end, *scope);
+        unit->hit = cache_get(ctx->cache, unit->key, &ctx->arena, &unit->js, &unit->length, &unit->cost);
+    }
+    if(unit->hit){
+        ctx->stats.cacheHits++;
+        ctx->stats.cacheSecondsSaved += unit->cost - (now_seconds() - begin);
+        unit->node = ast_node(&ctx->ast, NODE_CACHED, start + 1);
+        ctx->ast.nodes[unit->node].tokenEnd = ctx->unitCount;
+        ctx->currentToken = end;
+    }else{
+        unit->node = function_definition(ctx);
+        // Keyed by what the parser consumed, should the brace count differ.
+        unit->key = hash_tokens(ctx, start, ctx->currentToken, *scope);
+        unit->cost = now_seconds() - begin;
+    }
+    ctx->unitCount++;
+    *scope = hash_tokens(ctx, start + 1, start + 2, *scope);
+    return ctx->units[ctx->unitCount - 1].node;
+}
+
+static uint32_t external_declaration(C2jsContext *ctx){
+    if(ctx->tokens.types[ctx->currentToken] == DATA_TYPES){
+        if(ctx->tokens.types[ctx->currentToken+2] == LPAREN){
+            return function_definition(ctx);
+        } else {
+            return declaration(ctx);
+        }
+    }else if(ctx->tokens.types[ctx->currentToken] == PREPROCESSOR){
+        uint32_t node = node_here(ctx, NODE_PREPROCESSOR);
+        match(ctx, PREPROCESSOR);
+        return node;
+    }
+    return AST_NONE;
+}
+
+static uint32_t function_definition(C2jsContext *ctx){
+    trace(ctx, C2JS_TRACE_TRACE, "Function definition\n");
+    trace(ctx, C2JS_TRACE_TRACE, "<%s, %.*s, %d>\n", token_type_strings[ctx->tokens.types[ctx->currentToken]], TOKEN_TEXT(ctx->source, ctx->tokens, ctx->currentToken), token_line(ctx, ctx->currentToken));
+    match(ctx, DATA_TYPES);
+    uint32_t node = node_here(ctx, NODE_FUNCTION);
+    uint32_t last = AST_NONE;
+    match(ctx, ID);
+    match(ctx, LPAREN);
+    trace(ctx, C2JS_TRACE_TRACE, "Current: %.*s\n", TOKEN_TEXT(ctx->source, ctx->tokens, ctx->currentToken));
+
+    while(ctx->tokens.types[ctx->currentToken] != RPAREN){
+        parameter_list(ctx, node, &last);
+    }
+    trace(ctx, C2JS_TRACE_TRACE, "Current: %.*s\n", TOKEN_TEXT(ctx->source, ctx->tokens, ctx->currentToken));
+    match(ctx, RPAREN);
+    ast_append(&ctx->ast, node, &last, block(ctx));
+    return node;
+}
+
+static uint32_t block(C2jsContext *ctx){
+    uint32_t node = node_here(ctx, NODE_BLOCK);
+    uint32_t last = AST_NONE;
+    match(ctx, LBRACE);
+    while(ctx->tokens.types[ctx->currentToken] != RBRACE){
+        ast_append(&ctx->ast, node, &last, statement(ctx));
+    }
+    match(ctx, RBRACE);
+    return node;
+}
+
+static uint32_t expression_statement(C2jsContext *ctx){
+    uint32_t node = node_here(ctx, NODE_EXPRESSION_STATEMENT);
+    uint32_t last = AST_NONE;
+    ast_append(&ctx->ast, node, &last, expression(ctx));
+    match(ctx, SEMICOLON);
+    return node;
+}
+
+static uint32_t return_statement(C2jsContext *ctx){
+    uint32_t node = node_here(ctx, NODE_RETURN);
+    uint32_t last = AST_NONE;
+    match(ctx, KEYWORDS);
+    ast_append(&ctx->ast, node, &last, expression(ctx));
+    match(ctx, SEMICOLON);
+    return node;
+}
+
+// The tokens from start up to the current one, as an unstructured leaf.
+static uint32_t token_run(C2jsContext *ctx, int start){
+    uint32_t node = ast_node(&ctx->ast, NODE_TOKENS, start);
+    ctx->ast.nodes[node].tokenEnd = ctx->currentToken;
+    return node;
+}
+
+static uint32_t statement(C2jsContext *ctx){
+    int type = ctx->tokens.types[ctx->currentToken];
+    if(type == DATA_TYPES){
+        return dataTypeDeclaration(ctx);
+    }else if(type == INPUTS){
+        return inputStatement(ctx);
+    }else if(type == OUTPUTS){
+        return outputStatement(ctx);
+    }else if(type == LOOP){
+        return loopStatement(ctx);
+    }else if(type == CONDITIONAL){
+        return conditionalStatement(ctx);
+    }else if(type == FUNCTION){
+        return functionCall(ctx);
+    }else if(type == ID){
+        if(ctx->tokens.types[ctx->currentToken+1] == LPAREN){
+            uint32_t node = node_here(ctx, NODE_CALL);
+            uint32_t last = AST_NONE;
+            match(ctx, ID);
+            match(ctx, LPAREN);
+            int arguments = ctx->currentToken;
+            while(ctx->tokens.types[ctx->currentToken] != RPAREN){
+                match(ctx, ctx->tokens.types[ctx->currentToken]);
+                if(ctx->tokens.types[ctx->currentToken] == OP){
+                    match(ctx, OP);
+                }
+                if(ctx->tokens.types[ctx->currentToken] == COMMA){
+                    match(ctx, COMMA);
+                }
+            }
+            ast_append(&ctx->ast, node, &last, token_run(ctx, arguments));
+            match(ctx, RPAREN);
+            match(ctx, SEMICOLON);
+            return node;
+        }else{
+        return expression_statement(ctx);
+        }
+    }else if(type == KEYWORDS){
+        if(ctx->tokens.ids[ctx->currentToken] == KW_RETURN){
+            return return_statement(ctx);
+        }else if(ctx->tokens.ids[ctx->currentToken] == KW_CASE){
+            return case_statement(ctx);
+        }else if(ctx->tokens.ids[ctx->currentToken] == KW_DEFAULT){
+            return default_statement(ctx);
+        }else if(ctx->tokens.ids[ctx->currentToken] == KW_DO){
+            // "do" lexes as a keyword, not a loop.
+            return do_while_statement(ctx);
+        }
+        // Any other keyword would never be consumed.
+        trace(ctx, C2JS_TRACE_ERROR, "Syntax error at line %d, column %d\n", token_line(ctx, ctx->currentToken), token_column(ctx, ctx->currentToken));
+        syntax_error(ctx);
+    }else if(type == COMMENT){
+        return ast_node(&ctx->ast, NODE_COMMENT, ctx->currentToken++);
+    }else{
+        trace(ctx, C2JS_TRACE_ERROR, "Syntax error at line %d, column %d\n", token_line(ctx, ctx->currentToken), token_column(ctx, ctx->currentToken));
+        syntax_error(ctx);
+    }
+    return AST_NONE;
+}
+
+static void parameter_list(C2jsContext *ctx, uint32_t function, uint32_t *last){
+    ast_append(&ctx->ast, function, last, parameter(ctx));
+    while(ctx->tokens.types[ctx->currentToken] == COMMA){
+        match(ctx, COMMA);
+        ast_append(&ctx->ast, function, last, parameter(ctx));
+    }
+}
+
+static uint32_t parameter(C2jsContext *ctx){
+    match(ctx, DATA_TYPES);
+    uint32_t node = node_here(ctx, NODE_PARAM);
+    match(ctx, ID);
+    return node;
+}
+
+static uint32_t declaration(C2jsContext *ctx){
+    int type = ctx->tokens.types[ctx->currentToken];
+    if (ctx->tokens.types[ctx->currentToken] == DATA_TYPES)
+    {
+        return dataTypeDeclaration(ctx);
+    }
+    else if (ctx->tokens.types[ctx->currentToken] == INPUTS)
+    {
+        return inputStatement(ctx);
+    }
+    else if (ctx->tokens.types[ctx->currentToken] == OUTPUTS)
+    {
+        return outputStatement(ctx);
+    }
+    else if (ctx->tokens.types[ctx->currentToken] == LOOP)
+    {
+        trace(ctx, C2JS_TRACE_TRACE, "Loop\n");
+        return loopStatement(ctx);
+    }
+    else if (ctx->tokens.types[ctx->currentToken] == CONDITIONAL)
+    {
+        return conditionalStatement(ctx);
+    }
+    else if (ctx->tokens.types[ctx->currentToken] == FUNCTION)
+    {
+        return functionCall(ctx);
+    }else if(ctx->tokens.types[ctx->currentToken] == COMMENT){
+        return ast_node(&ctx->ast, NODE_COMMENT, ctx->currentToken++);
+    }else if(ctx->tokens.types[ctx->currentToken] == ID){
+        trace(ctx, C2JS_TRACE_TRACE, "Declaration without a data type\n");
+        int start = ctx->currentToken;
+        match(ctx, ID);
+        if(ctx->tokens.types[ctx->currentToken] == LPAREN){
+            match(ctx, LPAREN);
+            while(ctx->tokens.types[ctx->currentToken] != RPAREN){
+                match(ctx, ctx->tokens.types[ctx->currentToken]);
+                match(ctx, COMMA);
+            }
+            match(ctx, RPAREN);
+            match(ctx, SEMICOLON);
+        }
+        return token_run(ctx, start);
+    }
+    return AST_NONE;
+}
+
+// Operators all bind alike, so an expression is a flat, left-to-right list
+// of operands and operators; only parentheses nest.
+static uint32_t expression(C2jsContext *ctx){
+    uint32_t node = node_here(ctx, NODE_EXPRESSION);
+    uint32_t last = AST_NONE;
+    term(ctx, node, &last);
+    while(ctx->tokens.types[ctx->currentToken] == OP || ctx->tokens.types[ctx->currentToken] == ASSIGNMENT){
+        ast_append(&ctx->ast, node, &last, node_here(ctx, NODE_OPERATOR));
+        if(ctx->tokens.types[ctx->currentToken] == ASSIGNMENT){
+            match(ctx, ASSIGNMENT);
+        }else{
+            match(ctx, OP);
+        }
+        term(ctx, node, &last);
+    }
+    return node;
+}
+
+static void term(C2jsContext *ctx, uint32_t expr, uint32_t *last){
+    factor(ctx, expr, last);
+    while(ctx->tokens.types[ctx->currentToken] == OP || ctx->tokens.types[ctx->currentToken] == ASSIGNMENT){
+        ast_append(&ctx->ast, expr, last, node_here(ctx, NODE_OPERATOR));
+        if(ctx->tokens.types[ctx->currentToken] == ASSIGNMENT){
+            match(ctx, ASSIGNMENT);
+        }else{
+            match(ctx, OP);
+        }
+        factor(ctx, expr, last);
+    }
+}
+
+static void factor(C2jsContext *ctx, uint32_t expr, uint32_t *last){
+    if(ctx->tokens.types[ctx->currentToken] == LPAREN){
+        uint32_t node = node_here(ctx, NODE_PAREN);
+        uint32_t inner = AST_NONE;
+        match(ctx, LPAREN);
+        ast_append(&ctx->ast, node, &inner, expression(ctx));
+        match(ctx, RPAREN);
+        ast_append(&ctx->ast, expr, last, node);
+    }else if(ctx->tokens.types[ctx->currentToken] == ID){
+        ast_append(&ctx->ast, expr, last, node_here(ctx, NODE_NAME));
+        match(ctx, ID);
+    }else if(ctx->tokens.types[ctx->currentToken] == NUM){
+        ast_append(&ctx->ast, expr, last, node_here(ctx, NODE_NUMBER));
+        match(ctx, NUM);
+    }
+}
+
+static uint32_t functionCall(C2jsContext *ctx){
+    uint32_t node = node_here(ctx, NODE_FUNCTION_CALL);
+    uint32_t last = AST_NONE;
+    match(ctx, FUNCTION);
+    match(ctx, LPAREN);
+    while(ctx->tokens.types[ctx->currentToken] != RPAREN){
+        ast_append(&ctx->ast, node, &last, expression(ctx));
+    }
+    match(ctx, RPAREN);
+    match(ctx, SEMICOLON);
+    return node;
+}
+
+static uint32_t conditionalStatement(C2jsContext *ctx){
+    if(ctx->tokens.ids[ctx->currentToken] == KW_IF){
+        return if_statement(ctx);
+    }else if(ctx->tokens.ids[ctx->currentToken] == KW_SWITCH){
+        return switch_statement(ctx);
+    }
+    return AST_NONE;
+}
+
+static uint32_t if_statement(C2jsContext *ctx){
+    uint32_t node = node_here(ctx, NODE_IF);
+    uint32_t last = AST_NONE;
+    match(ctx, CONDITIONAL);
+    match(ctx, LPAREN);
+    ast_append(&ctx->ast, node, &last, expression(ctx));
+    match(ctx, RPAREN);
+    ast_append(&ctx->ast, node, &last, block(ctx));
+    ast_append(&ctx->ast, node, &last, else_statement(ctx));
+    return node;
+}
+
+static uint32_t else_statement(C2jsContext *ctx){
+    if(ctx->tokens.ids[ctx->currentToken] == KW_ELSE){
+        uint32_t node = node_here(ctx, NODE_ELSE);
+        uint32_t last = AST_NONE;
+        match(ctx, CONDITIONAL);
+        ast_append(&ctx->ast, node, &last, block(ctx));
+        return node;
+    }
+    return AST_NONE;
+}
+
+static uint32_t switch_statement(C2jsContext *ctx){
+    uint32_t node = node_here(ctx, NODE_SWITCH);
+    uint32_t last = AST_NONE;
+    match(ctx, CONDITIONAL);
+    match(ctx, LPAREN);
+    ast_append(&ctx->ast, node, &last, expression(ctx));
+    match(ctx, RPAREN);
+    uint32_t body = node_here(ctx, NODE_BLOCK);
+    uint32_t lastCase = AST_NONE;
+    match(ctx, LBRACE);
+    while(ctx->tokens.types[ctx->currentToken] != RBRACE){
+        ast_append(&ctx->ast, body, &lastCase, case_statement(ctx));
+    }
+    match(ctx, RBRACE);
+    ast_append(&ctx->ast, node, &last, body);
+    return node;
+}
+
+static uint32_t case_statement(C2jsContext *ctx){
+    uint32_t node = node_here(ctx, NODE_CASE);
+    uint32_t last = AST_NONE;
+    match(ctx, KEYWORDS);
+    match(ctx, NUM);
+    match(ctx, COLON);
+    while(ctx->tokens.types[ctx->currentToken] != RBRACE){
+        if(ctx->tokens.ids[ctx->currentToken] == KW_BREAK){
+            ast_append(&ctx->ast, node, &last, node_here(ctx, NODE_BREAK));
+            match(ctx, KEYWORDS);
+            match(ctx, SEMICOLON);
+        }else{
+            ast_append(&ctx->ast, node, &last, statement(ctx));
+        }
+    }
+    return node;
+}
+
+static uint32_t default_statement(C2jsContext *ctx){
+    if(ctx->tokens.ids[ctx->currentToken] == KW_DEFAULT){
+        uint32_t node = node_here(ctx, NODE_DEFAULT);
+        uint32_t last = AST_NONE;
+        match(ctx, KEYWORDS);
+        match(ctx, COLON);
+        while(ctx->tokens.types[ctx->currentToken] != RBRACE){
+            if(ctx->tokens.ids[ctx->currentToken] == KW_BREAK){
+                ast_append(&ctx->ast, node, &last, node_here(ctx, NODE_BREAK));
+                match(ctx, KEYWORDS);
+                match(ctx, SEMICOLON);
+            }else{
+                ast_append(&ctx->ast, node, &last, statement(ctx));
+            }
+        }
+        return node;
+    }
+    return AST_NONE;
+}
+
+static uint32_t loopStatement(C2jsContext *ctx)
+{
+    trace(ctx, C2JS_TRACE_TRACE, "Value: %.*s\n", TOKEN_TEXT(ctx->source, ctx->tokens, ctx->currentToken));
+    if (ctx->tokens.ids[ctx->currentToken] == KW_FOR)
+    {
+        return for_statement(ctx);
+    }
+    else if (ctx->tokens.ids[ctx->currentToken] == KW_WHILE)
+    {
+        return while_statement(ctx);
+    }
+    else if (ctx->tokens.ids[ctx->currentToken] == KW_DO)
+    {
+        return do_while_statement(ctx);
+    }
+    return AST_NONE;
+}
+
+static uint32_t do_while_statement(C2jsContext *ctx){
+    uint32_t node = node_here(ctx, NODE_DO_WHILE);
+    uint32_t last = AST_NONE;
+    match(ctx, KEYWORDS);
+    ast_append(&ctx->ast, node, &last, block(ctx));
+    match(ctx, LOOP);
+    match(ctx, LPAREN);
+    ast_append(&ctx->ast, node, &last, expression(ctx));
+    match(ctx, RPAREN);
+    match(ctx, SEMICOLON);
+    return node;
+}
+
+static uint32_t while_statement(C2jsContext *ctx){
+    uint32_t node = node_here(ctx, NODE_WHILE);
+    uint32_t last = AST_NONE;
+    match(ctx, LOOP);
+    match(ctx, LPAREN);
+    ast_append(&ctx->ast, node, &last, expression(ctx));
+    match(ctx, RPAREN);
+    ast_append(&ctx->ast, node, &last, block(ctx));
+    return node;
+}
+
+static uint32_t for_statement(C2jsContext *ctx){
+    uint32_t node = node_here(ctx, NODE_FOR);
+    uint32_t last = AST_NONE;
+    match(ctx, LOOP);
+    match(ctx, LPAREN);
+    ast_append(&ctx->ast, node, &last, declaration(ctx));
+    ast_append(&ctx->ast, node, &last, node_here(ctx, NODE_NAME));
+    match(ctx, ID);
+    match(ctx, OP);
+    match(ctx, NUM);
+    match(ctx, SEMICOLON);
+    ast_append(&ctx->ast, node, &last, node_here(ctx, NODE_NAME));
+    match(ctx, ID);
+    match(ctx, OP);
+    match(ctx, RPAREN);
+    ctx->ast.nodes[node].tokenEnd = ctx->currentToken;
+    ast_append(&ctx->ast, node, &last, block(ctx));
+    return node;
+}
+
+static uint32_t outputStatement(C2jsContext *ctx){
+    uint32_t node = node_here(ctx, NODE_OUTPUT);
+    uint32_t last = AST_NONE;
+    match(ctx, OUTPUTS);
+    match(ctx, LPAREN);
+    ast_append(&ctx->ast, node, &last, node_here(ctx, NODE_STRING));
+    match(ctx, STRING);
+    while(ctx->tokens.types[ctx->currentToken] != RPAREN){
+        match(ctx, COMMA);
+        ast_append(&ctx->ast, node, &last, node_here(ctx, NODE_NAME));
+        match(ctx, ID);
+    }
+    match(ctx, RPAREN);
+    match(ctx, SEMICOLON);
+    return node;
+}
+
+static uint32_t inputStatement(C2jsContext *ctx){
+    uint32_t node = node_here(ctx, NODE_INPUT);
+    uint32_t last = AST_NONE;
+    match(ctx, INPUTS);
+    int arguments = ctx->currentToken;
+    match(ctx, LPAREN);
+    match(ctx, STRING);
+    match(ctx, COMMA);
+    match(ctx, ID);
+    while(ctx->tokens.types[ctx->currentToken] != RPAREN){
+        match(ctx, ID);
+        if(ctx->tokens.types[ctx->currentToken] == COMMA){
+            match(ctx, COMMA);
+        }
+    }
+    match(ctx, RPAREN);
+    ast_append(&ctx->ast, node, &last, token_run(ctx, arguments));
+    match(ctx, SEMICOLON);
+    return node;
+}
+
+static uint32_t dataTypeDeclaration(C2jsContext *ctx){
+    trace(ctx, C2JS_TRACE_TRACE, "\n From data type: \n");
+    int type = ctx->tokens.types[ctx->currentToken];
+    uint32_t node = node_here(ctx, NODE_DECLARATION);
+    uint32_t last = AST_NONE;
+    uint32_t declarator;
+    if(ctx->tokens.ids[ctx->currentToken] == KW_CHAR){
+        match(ctx, DATA_TYPES);
+        declarator = node_here(ctx, NODE_DECLARATOR);
+        match(ctx, ID);
+        match(ctx, LBRACKET);
+        while(ctx->tokens.types[ctx->currentToken] != RBRACKET){
+            match(ctx, NUM);
+        }
+        match(ctx, RBRACKET);
+    }else{
+        match(ctx, DATA_TYPES);
+        declarator = node_here(ctx, NODE_DECLARATOR);
+        match(ctx, ID);
+    }
+    ast_append(&ctx->ast, node, &last, declarator);
+    type = ctx->tokens.types[ctx->currentToken];
+    trace(ctx, C2JS_TRACE_TRACE, "Current: %.*s\n", TOKEN_TEXT(ctx->source, ctx->tokens, ctx->currentToken));
+    if (type == ASSIGNMENT)
+    {
+        uint32_t initializer = AST_NONE;
+        match(ctx, ASSIGNMENT);
+        ast_append(&ctx->ast, declarator, &initializer, expression(ctx));
+    }
+    while (ctx->tokens.types[ctx->currentToken] == COMMA)
+    {
+        match(ctx, COMMA);
+        declarator = node_here(ctx, NODE_DECLARATOR);
+        ast_append(&ctx->ast, node, &last, declarator);
+        match(ctx, ID);
+        if (type == ASSIGNMENT)
+        {
+            uint32_t initializer = AST_NONE;
+            match(ctx, ASSIGNMENT);
+            ast_append(&ctx->ast, declarator, &initializer, expression(ctx));
+        }
+    }
+    match(ctx, SEMICOLON);
+    return node;
+}
+
+// The traces of match(), kept out of line so match() stays small enough to
+// inline into the parser.
+__attribute__((cold, noinline))
+static void trace_match(C2jsContext *ctx, TokenType expected){
+    trace(ctx, C2JS_TRACE_TRACE, "From Match: \n");
+    trace(ctx, C2JS_TRACE_TRACE, "<%s, %.*s, %d>\n", token_type_strings[ctx->tokens.types[ctx->currentToken]], TOKEN_TEXT(ctx->source, ctx->tokens, ctx->currentToken), token_line(ctx, ctx->currentToken));
+    trace(ctx, C2JS_TRACE_TRACE, "expected: %s\n", token_type_strings[expected]);
+}
+
+__attribute__((cold, noinline))
+static void match_failed(C2jsContext *ctx){
+    trace(ctx, C2JS_TRACE_ERROR, "Syntax error at lines %d, column %d\n", token_line(ctx, ctx->currentToken), token_column(ctx, ctx->currentToken));
+    syntax_error(ctx);
+}
+
+static void match(C2jsContext *ctx, TokenType expected){
+    if(tracing(ctx, C2JS_TRACE_TRACE)){
+        trace_match(ctx, expected);
+    }
+    if(ctx->tokens.types[ctx->currentToken] == expected){
+        ctx->currentToken++;
+    } else {
+        match_failed(ctx);
+    }
+}
+
+// Semantic Analysis
+static int check_node(C2jsContext *ctx, uint32_t index);
+
+// Whether an earlier window of a stream declared the name at tokenIndex.
+static bool global_declared(const C2jsContext *ctx, uint32_t tokenIndex)
+{
+    if (!ctx->globals)
+    {
+        return false;
+    }
+    uint32_t name = intern_find(&ctx->globals->interner, token_text(ctx->source, &ctx->tokens, tokenIndex), ctx->tokens.lengths[tokenIndex]);
+    return name != INTERN_NONE && symtab_lookup(&ctx->globals->symbols, name) != NULL;
+}
+
+static int check_use(C2jsContext *ctx, uint32_t tokenIndex)
+{
+    // Check if the identifier is declared
+    if (symtab_lookup(&ctx->symbols, ctx->tokens.ids[tokenIndex]) == NULL && !global_declared(ctx, tokenIndex))
+    {
+        trace(ctx, C2JS_TRACE_ERROR, "Semantic Error: Undeclared variable %.*s at line %d, column %d\n",
+              TOKEN_TEXT(ctx->source, ctx->tokens, tokenIndex), token_line(ctx, tokenIndex), token_column(ctx, tokenIndex));
+        return 1;
+    }
+    return 0;
+}
+
+static int check_children(C2jsContext *ctx, uint32_t index)
+{
+    int semanticErrors = 0;
+    for (uint32_t child = ctx->ast.nodes[index].firstChild; child != AST_NONE; child = ctx->ast.nodes[child].nextSibling)
+    {
+        semanticErrors += check_node(ctx, child);
+    }
+    return semanticErrors;
+}
+
+// Declarations take effect in source order, so a name is visible from its
+// declarator onwards and until the end of the enclosing block.
+static int check_node(C2jsContext *ctx, uint32_t index)
+{
+    const AstNode *node = &ctx->ast.nodes[index];
+    int semanticErrors = 0;
+
+    switch (node->kind)
+    {
+    case NODE_FUNCTION:
+        symtab_declare(&ctx->symbols, ctx->tokens.ids[node->token], ctx->tokens.ids[node->token - 1]);
+        // Parameters and the body's locals share the function's scope.
+        symtab_enter_scope(&ctx->symbols);
+        for (uint32_t child = node->firstChild; child != AST_NONE; child = ctx->ast.nodes[child].nextSibling)
+        {
+            const AstNode *part = &ctx->ast.nodes[child];
+            if (part->kind == NODE_PARAM)
+            {
+                symtab_declare(&ctx->symbols, ctx->tokens.ids[part->token], ctx->tokens.ids[part->token - 1]);
+            }
+            else
+            {
+                semanticErrors += check_children(ctx, child);
+            }
+        }
+        symtab_leave_scope(&ctx->symbols);
+        break;
+    case NODE_BLOCK:
+    case NODE_FOR: // the loop variable is scoped to the whole statement
+        symtab_enter_scope(&ctx->symbols);
+        semanticErrors += check_children(ctx, index);
+        symtab_leave_scope(&ctx->symbols);
+        break;
+    case NODE_DECLARATION:
+        for (uint32_t child = node->firstChild; child != AST_NONE; child = ctx->ast.nodes[child].nextSibling)
+        {
+            symtab_declare(&ctx->symbols, ctx->tokens.ids[ctx->ast.nodes[child].token], ctx->tokens.ids[node->token]);
+            semanticErrors += check_children(ctx, child);
+        }
+        break;
+    case NODE_CACHED:
+        symtab_declare(&ctx->symbols, ctx->tokens.ids[node->token], ctx->tokens.ids[node->token - 1]);
+        break;
+    case NODE_NAME:
+        semanticErrors += check_use(ctx, node->token);
+        break;
+    case NODE_CALL:
+        semanticErrors += check_use(ctx, node->token);
+        semanticErrors += check_children(ctx, index);
+        break;
+    case NODE_TOKENS:
+        for (uint32_t i = node->token; i < node->tokenEnd; i++)
+        {
+            if (ctx->tokens.types[i] == ID)
+            {
+                semanticErrors += check_use(ctx, i);
+            }
+        }
+        break;
+    default:
+        semanticErrors += check_children(ctx, index);
+        break;
+    }
+    return semanticErrors;
+}
+
+static int semantic_analysis(C2jsContext *ctx)
+{
+    if (ctx->ast.root == AST_NONE)
+    {
+        return 0;
+    }
+    if (!ctx->cache)
+    {
+        return check_node(ctx, ctx->ast.root);
+    }
+
+    // One top-level declaration at a time, charging each function's time
+    // to its cache entry.
+    int semanticErrors = 0;
+    uint32_t unit = 0;
+    for (uint32_t child = ctx->ast.nodes[ctx->ast.root].firstChild; child != AST_NONE; child = ctx->ast.nodes[child].nextSibling)
+    {
+        double start = now_seconds();
+        semanticErrors += check_node(ctx, child);
+        if (unit < ctx->unitCount && ctx->units[unit].node == child)
+        {
+            ctx->units[unit++].cost += now_seconds() - start;
+        }
+    }
+    return semanticErrors;
+}
+
+// Copies the token's bytes straight from the source slice.
+static void emit_token(C2jsContext *ctx, OutputSink *out, uint32_t token)
+{
+    sink_write(out, token_text(ctx->source, &ctx->tokens, token), ctx->tokens.lengths[token]);
+}
+
+// Emits the tokens of an unstructured run one by one.
+static void emit_tokens(C2jsContext *ctx, OutputSink *out, uint32_t start, uint32_t end)
+{
+    for (uint32_t i = start; i < end; i++)
+    {
+        TokenType type = ctx->tokens.types[i];
+
+        if(ctx->tokens.ids[i] == KW_BREAK){
+            sink_literal(out, "\t\tbreak");
+        }
+        else if (type == ID)
+        {
+            emit_token(ctx, out, i);
+            if (i + 1 < end && ctx->tokens.types[i + 1] == LBRACKET)
+            {
+                uint32_t j = i + 1;
+                while (j + 1 < end && ctx->tokens.types[j] != RBRACKET)
+                {
+                    j++;
+                }
+                i = j;
+            }
+        }
+        else if (type == KEYWORDS)
+        {
+            if (ctx->tokens.ids[i] == KW_CASE)
+            {
+                sink_literal(out, "case ");
+            }
+            else
+            {
+                emit_token(ctx, out, i);
+            }
+        }
+        else if (type == OP || type == NUM)
+        {
+            emit_token(ctx, out, i);
+        }
+        else if (type == STRING || type == CHAR)
+        {
+            sink_literal(out, "\"");
+            emit_token(ctx, out, i);
+            sink_literal(out, "\"");
+        }
+        else if (type == COLON)
+        {
+            sink_literal(out, ": ");
+        }
+        else if (type == PUNCTUATORS || type == LPAREN || type == RPAREN ||
+                 type == LBRACE || type == RBRACE || type == LBRACKET ||
+                 type == RBRACKET || type == SEMICOLON || type == COMMA || type == DOT)
+        {
+            emit_token(ctx, out, i);
+            if (type == SEMICOLON || type == LBRACE || type == RBRACE)
+            {
+                sink_literal(out, "\n");
+            }
+        }
+        else if (type == ASSIGNMENT)
+        {
+            sink_literal(out, " = ");
+        }
+        else if (type == DATA_TYPES)
+        {
+            sink_literal(out, "let ");
+        }
+        else if (type == INPUTS)
+        {
+            sink_literal(out, "prompt(");
+        }
+        else if (type == OUTPUTS)
+        {
+            sink_literal(out, "console.log(");
+        }
+        else if (type == LOOP || type == CONDITIONAL || type == FUNCTION)
+        {
+            emit_token(ctx, out, i);
+        }
+        else
+        {
+            trace(ctx, C2JS_TRACE_ERROR, "/* Unhandled token type: %.*s */", TOKEN_TEXT(ctx->source, ctx->tokens, i));
+        }
+    }
+}
+
+static void emit_node(C2jsContext *ctx, OutputSink *out, uint32_t index);
+
+// Emits each child in turn, with separator between them if it is not NULL.
+static void emit_children(C2jsContext *ctx, OutputSink *out, uint32_t index, const char *separator)
+{
+    for (uint32_t child = ctx->ast.nodes[index].firstChild; child != AST_NONE; child = ctx->ast.nodes[child].nextSibling)
+    {
+        if (separator && child != ctx->ast.nodes[index].firstChild)
+        {
+            sink_write(out, separator, strlen(separator));
+        }
+        emit_node(ctx, out, child);
+    }
+}
+
+static void emit_node(C2jsContext *ctx, OutputSink *out, uint32_t index)
+{
+    const AstNode *node = &ctx->ast.nodes[index];
+    uint32_t token = node->token;
+
+    switch (node->kind)
+    {
+    case NODE_PROGRAM:
+    case NODE_EXPRESSION:
+        emit_children(ctx, out, index, NULL);
+        break;
+    case NODE_FUNCTION:
+        sink_literal(out, "function ");
+        emit_token(ctx, out, token);
+        sink_literal(out, "(");
+        for (uint32_t child = node->firstChild; child != AST_NONE; child = ctx->ast.nodes[child].nextSibling)
+        {
+            if (ctx->ast.nodes[child].kind == NODE_PARAM)
+            {
+                if (child != node->firstChild)
+                {
+                    sink_literal(out, ",");
+                }
+                emit_token(ctx, out, ctx->ast.nodes[child].token);
+            }
+            else
+            {
+                sink_literal(out, ")");
+                emit_node(ctx, out, child);
+            }
+        }
+        break;
+    case NODE_BLOCK:
+        sink_literal(out, "{\n");
+        emit_children(ctx, out, index, NULL);
+        sink_literal(out, "}\n");
+        break;
+    case NODE_DECLARATION:
+        sink_literal(out, "let ");
+        emit_children(ctx, out, index, ",");
+        sink_literal(out, ";\n");
+        break;
+    case NODE_DECLARATOR:
+        emit_token(ctx, out, token);
+        if (node->firstChild != AST_NONE)
+        {
+            sink_literal(out, " = ");
+            emit_node(ctx, out, node->firstChild);
+        }
+        break;
+    case NODE_NAME:
+    case NODE_NUMBER:
+        emit_token(ctx, out, token);
+        break;
+    case NODE_STRING:
+        sink_literal(out, "\"");
+        emit_token(ctx, out, token);
+        sink_literal(out, "\"");
+        break;
+    case NODE_OPERATOR:
+        if (ctx->tokens.types[token] == ASSIGNMENT)
+        {
+            sink_literal(out, " = ");
+        }
+        else
+        {
+            emit_token(ctx, out, token);
+        }
+        break;
+    case NODE_PAREN:
+        sink_literal(out, "(");
+        emit_children(ctx, out, index, NULL);
+        sink_literal(out, ")");
+        break;
+    case NODE_EXPRESSION_STATEMENT:
+        emit_children(ctx, out, index, NULL);
+        sink_literal(out, ";\n");
+        break;
+    case NODE_CALL:
+    case NODE_FUNCTION_CALL:
+        emit_token(ctx, out, token);
+        sink_literal(out, "(");
+        emit_children(ctx, out, index, NULL);
+        sink_literal(out, ");\n");
+        break;
+    case NODE_RETURN:
+        // No space after the keyword: the translator has always joined it
+        // to the returned expression.
+        emit_token(ctx, out, token);
+        emit_children(ctx, out, index, NULL);
+        sink_literal(out, ";\n");
+        break;
+    case NODE_IF:
+    case NODE_WHILE:
+    case NODE_SWITCH:
+    {
+        uint32_t condition = node->firstChild;
+        emit_token(ctx, out, token);
+        sink_literal(out, "(");
+        emit_node(ctx, out, condition);
+        sink_literal(out, ")");
+        for (uint32_t child = ctx->ast.nodes[condition].nextSibling; child != AST_NONE; child = ctx->ast.nodes[child].nextSibling)
+        {
+            emit_node(ctx, out, child);
+        }
+        break;
+    }
+    case NODE_ELSE:
+        emit_token(ctx, out, token);
+        emit_children(ctx, out, index, NULL);
+        break;
+    case NODE_DO_WHILE:
+        sink_literal(out, "do");
+        emit_node(ctx, out, node->firstChild);
+        sink_literal(out, "while(");
+        emit_node(ctx, out, ctx->ast.nodes[node->firstChild].nextSibling);
+        sink_literal(out, ");\n");
+        break;
+    case NODE_FOR:
+        sink_literal(out, "for");
+        for (uint32_t i = node->token + 1; i < node->tokenEnd; i++)
+        {
+            if(ctx->tokens.types[i] == SEMICOLON){
+                sink_literal(out, "; ");
+            }else if(ctx->tokens.types[i] == DATA_TYPES){
+                sink_literal(out, "let ");
+            }else{
+                emit_token(ctx, out, i);
+            }
+        }
+        for (uint32_t child = node->firstChild; child != AST_NONE; child = ctx->ast.nodes[child].nextSibling)
+        {
+            if (ctx->ast.nodes[child].kind == NODE_BLOCK)
+            {
+                emit_node(ctx, out, child);
+            }
+        }
+        break;
+    case NODE_CASE:
+        sink_literal(out, "case ");
+        emit_token(ctx, out, node->token + 1);
+        sink_literal(out, ": ");
+        emit_children(ctx, out, index, NULL);
+        break;
+    case NODE_DEFAULT:
+        sink_literal(out, "default: ");
+        emit_children(ctx, out, index, NULL);
+        break;
+    case NODE_BREAK:
+        sink_literal(out, "\t\tbreak;\n");
+        break;
+    case NODE_OUTPUT:
+        // With arguments only they are printed; the format string is
+        // dropped.
+        sink_literal(out, "console.log(");
+        if (ctx->ast.nodes[node->firstChild].nextSibling != AST_NONE)
+        {
+            for (uint32_t child = ctx->ast.nodes[node->firstChild].nextSibling; child != AST_NONE; child = ctx->ast.nodes[child].nextSibling)
+            {
+                if (child != ctx->ast.nodes[node->firstChild].nextSibling)
+                {
+                    sink_literal(out, ",");
+                }
+                emit_node(ctx, out, child);
+            }
+        }
+        else
+        {
+            emit_node(ctx, out, node->firstChild);
+        }
+        sink_literal(out, ");\n");
+        break;
+    case NODE_INPUT:
+        sink_literal(out, "prompt(");
+        emit_children(ctx, out, index, NULL);
+        sink_literal(out, ";\n");
+        break;
+    case NODE_COMMENT:
+        sink_literal(out, "// ");
+        emit_token(ctx, out, token);
+        sink_literal(out, "\n");
+        break;
+    case NODE_TOKENS:
+        emit_tokens(ctx, out, node->token, node->tokenEnd);
+        break;
+    case NODE_CACHED:
+        sink_write(out, ctx->units[node->tokenEnd].js, ctx->units[node->tokenEnd].length);
+        break;
+    default:
+        // Preprocessor directives have no JavaScript counterpart.
+        break;
+    }
+}
+
+static void convert_to_javascript(C2jsContext *ctx, OutputSink *out)
+{
+    if (ctx->ast.root != AST_NONE)
+    {
+        emit_node(ctx, out, ctx->ast.root);
+    }
+    trace(ctx, C2JS_TRACE_TRACE, "\n");
+}
+
+// Call the main function at the end of the JavaScript code
+static void generate_main_function_call(C2jsContext *ctx, OutputSink *out){
+    sink_literal(out, "main();");
+}
+
+static void convert_to_javascript_with_main_call(C2jsContext *ctx, OutputSink *out)
+{
+    convert_to_javascript(ctx, out);
+    generate_main_function_call(ctx, out);
+}
+
+// convert_to_javascript_with_main_call() through the cache: the output is
+// generated in memory, one top-level declaration at a time, so that every
+// function that was not a hit can be stored, and then the whole of it is
+// stored under fileKey and copied to out.
+static void convert_to_javascript_cached(C2jsContext *ctx, OutputSink *out, CacheKey fileKey)
+{
+    OutputSink *whole = &ctx->cacheOutput;
+    sink_reset(whole);
+    uint32_t unit = 0;
+    for (uint32_t child = ctx->ast.nodes[ctx->ast.root].firstChild; child != AST_NONE; child = ctx->ast.nodes[child].nextSibling)
+    {
+        size_t offset = whole->length;
+        double start = now_seconds();
+        emit_node(ctx, whole, child);
+        if (unit < ctx->unitCount && ctx->units[unit].node == child)
+        {
+            CacheUnit *current = &ctx->units[unit++];
+            if (!current->hit)
+            {
+                cache_put(ctx->cache, current->key, whole->data + offset, whole->length - offset, current->cost + now_seconds() - start);
+            }
+        }
+    }
+    trace(ctx, C2JS_TRACE_TRACE, "\n");
+    generate_main_function_call(ctx, whole);
+    cache_put(ctx->cache, fileKey, whole->data, whole->length, now_seconds() - ctx->translationStart);
+    sink_write(out, whole->data, whole->length);
+}
+
+C2jsContext *c2js_context_new(void)
+{
+    C2jsContext *ctx = calloc(1, sizeof(C2jsContext));
+    if (!ctx)
+    {
+        return NULL;
+    }
+    arena_init(&ctx->arena);
+    ctx->lines = &ctx->lineStore;
+    ctx->firstLine = ctx->firstColumn = 1;
+    ctx->log = stdout;
+    ctx->traceLevel = C2JS_TRACE_INFO;
+    return ctx;
+}
+
+void c2js_context_free(C2jsContext *ctx)
+{
+    if (!ctx)
+    {
+        return;
+    }
+    arena_free(&ctx->arena);
+    token_stream_free(&ctx->tokenStore);
+    line_index_free(&ctx->lineStore);
+    free(ctx->units);
+    for (int i = 0; i < ctx->shardCapacity; i++)
+    {
+        if (ctx->shards[i].ctx)
+        {
+            sink_close(&ctx->shards[i].output);
+            c2js_context_free(ctx->shards[i].ctx);
+        }
+    }
+    free(ctx->shards);
+    free(ctx->topNames);
+    if (ctx->cacheOutput.data)
+    {
+        sink_close(&ctx->cacheOutput);
+    }
+    free(ctx);
+}
+
+void c2js_set_log(C2jsContext *ctx, FILE *log)
+{
+    ctx->log = log;
+}
+
+void c2js_set_trace_level(C2jsContext *ctx, C2jsTraceLevel level)
+{
+    ctx->traceLevel = level;
+}
+
+// Set by the Makefile to a checksum of libc2js.c and the headers it
+// includes, so that any rebuilt translator keys its entries apart.
+#ifndef C2JS_SOURCE_HASH
+#define C2JS_SOURCE_HASH ""
+#endif
+
+// Seeds every cache key. The tables that decide how input lexes are hashed
+// whatever the build, and the sources' checksum covers the parser and code
+// generator.
+static CacheKey translator_version(void)
+{
+    CacheKey version = {CACHE_FORMAT, 0};
+    version = cache_key((const char *)keyword_table, sizeof(keyword_table), version);
+    version = cache_key((const char *)char_class, sizeof(char_class), version);
+    version = cache_key((const char *)punct_next, sizeof(punct_next), version);
+    version = cache_key((const char *)punct_types, sizeof(punct_types), version);
+    return cache_key(C2JS_SOURCE_HASH, strlen(C2JS_SOURCE_HASH), version);
+}
+
+C2jsCache *c2js_cache_open(const char *dir, size_t maxBytes)
+{
+    if (mkdir(dir, 0777) != 0 && errno != EEXIST)
+    {
+        return NULL;
+    }
+    C2jsCache *cache = calloc(1, sizeof(C2jsCache));
+    if (!cache)
+    {
+        return NULL;
+    }
+    cache->dir = strdup(dir);
+    cache->maxBytes = maxBytes;
+    cache->version = translator_version();
+    atomic_init(&cache->unTrimmed, 0);
+    atomic_init(&cache->tempCounter, 0);
+    pthread_mutex_init(&cache->trimLock, NULL);
+    return cache;
+}
+
+void c2js_cache_close(C2jsCache *cache)
+{
+    if (!cache)
+    {
+        return;
+    }
+    cache_trim(cache);
+    pthread_mutex_destroy(&cache->trimLock);
+    free(cache->dir);
+    free(cache);
+}
+
+void c2js_set_threads(C2jsContext *ctx, int threads)
+{
+    ctx->threads = threads;
+}
+
+void c2js_set_cache(C2jsContext *ctx, C2jsCache *cache)
+{
+    ctx->cache = cache;
+    if (cache && !ctx->cacheOutput.data)
+    {
+        sink_init_memory(&ctx->cacheOutput);
+    }
+}
+
+int c2js_error_line(const C2jsContext *ctx)
+{
+    return ctx->errorLine;
+}
+
+int c2js_error_column(const C2jsContext *ctx)
+{
+    return ctx->errorColumn;
+}
+
+// Everything a translation allocates lives in the arena, so one reset
+// releases it all and leaves the blocks ready for the next translation.
+static void reset_translation(C2jsContext *ctx)
+{
+    arena_reset(&ctx->arena);
+    interner_init(&ctx->interner, &ctx->arena);
+    symtab_init(&ctx->symbols, &ctx->arena);
+    ast_init(&ctx->ast, &ctx->arena);
+    ctx->tokens.count = 0;
+    ctx->lineStore.count = 0;
+    ctx->currentToken = 0;
+    ctx->errorLine = 0;
+    ctx->errorColumn = 0;
+    ctx->unitCount = 0;
+}
+
+// Charges the time since the previous phase ended to phase.
+static void phase_done(C2jsContext *ctx, C2jsPhase phase)
+{
+    double now = now_seconds();
+    ctx->stats.phaseSeconds[phase] += now - ctx->phaseStart;
+    ctx->stats.wallSeconds = now - ctx->translationStart;
+    ctx->phaseStart = now;
+}
+
+// Parallel translation of one file. Top-level declarations are independent
+// except that each one sees the names declared before it, so the token
+// stream is cut at top-level boundaries into shards, each with a private
+// context (AST, symbols, arena) over the shared tokens. Shards are parsed in
+// parallel; then the top-level names are gathered in order, and each shard
+// declares the ones before it before checking and emitting its own
+// declarations in parallel. Outputs and logs are concatenated in shard
+// order, so both match a sequential translation byte for byte.
+
+// Smaller inputs are not worth the threads.
+#define PARALLEL_MIN_TOKENS 65536
+
+typedef enum
+{
+    SHARD_PARSE,
+    SHARD_CHECK,
+    SHARD_EMIT
+} ShardPhase;
+
+
+typedef struct
+{
+    C2jsContext *parent;
+    int shardCount;
+    ShardPhase phase;
+    atomic_int next;
+} ShardQueue;
+
+// Returns the token one past the top-level declaration at start, or -1 if
+// it cannot be delimited without parsing.
+static int declaration_end(C2jsContext *ctx, int start)
+{
+    int eof = ctx->tokens.count - 1;
+    if (ctx->tokens.types[start] == PREPROCESSOR)
+    {
+        return start + 1;
+    }
+    if (ctx->tokens.types[start] != DATA_TYPES || start + 2 >= eof)
+    {
+        return -1;
+    }
+    if (ctx->tokens.types[start + 2] == LPAREN)
+    {
+        return function_end(ctx, start);
+    }
+    int end = start;
+    while (end < eof && ctx->tokens.types[end] != SEMICOLON && ctx->tokens.types[end] != LBRACE)
+    {
+        end++;
+    }
+    return end < eof && ctx->tokens.types[end] == SEMICOLON ? end + 1 : -1;
+}
+
+static Shard *shard_at(C2jsContext *ctx, int index)
+{
+    if (index == ctx->shardCapacity)
+    {
+        int capacity = ctx->shardCapacity ? ctx->shardCapacity * 2 : 16;
+        ctx->shards = realloc(ctx->shards, sizeof(Shard) * capacity);
+        if (!ctx->shards)
+        {
+            perror("Failed to allocate shards");
+            exit(EXIT_FAILURE);
+        }
+        memset(ctx->shards + ctx->shardCapacity, 0, sizeof(Shard) * (capacity - ctx->shardCapacity));
+        ctx->shardCapacity = capacity;
+    }
+    Shard *shard = &ctx->shards[index];
+    if (!shard->ctx)
+    {
+        shard->ctx = c2js_context_new();
+        sink_init_memory(&shard->output);
+    }
+    return shard;
+}
+
+// Cuts the tokens into about count shards of similar size. Returns the
+// number of shards, or 0 if a top-level declaration cannot be delimited
+// (the sequential parser then reports the problem).
+static int split_shards(C2jsContext *ctx, int count)
+{
+    int eof = ctx->tokens.count - 1;
+    int target = eof / count + 1;
+    int shardCount = 0;
+    int start = 0;
+    for (int i = 0; i < eof;)
+    {
+        int end = declaration_end(ctx, i);
+        if (end < 0)
+        {
+            return 0;
+        }
+        i = end;
+        if (i - start >= target || i == eof)
+        {
+            Shard *shard = shard_at(ctx, shardCount++);
+            shard->start = start;
+            shard->end = i;
+            start = i;
+        }
+    }
+    return shardCount;
+}
+
+static void shard_log_begin(Shard *shard)
+{
+    shard->log = open_memstream(&shard->logText, &shard->logLength);
+    shard->ctx->log = shard->log ? shard->log : stderr;
+}
+
+// Copies what the shard logged during the last phase to the parent's log.
+static void shard_log_replay(C2jsContext *parent, Shard *shard, bool replay)
+{
+    if (!shard->log)
+    {
+        return;
+    }
+    fclose(shard->log);
+    if (replay && shard->logLength > 0)
+    {
+        fwrite(shard->logText, 1, shard->logLength, parent->log);
+    }
+    free(shard->logText);
+    shard->log = NULL;
+    shard->logText = NULL;
+}
+
+static void shard_parse(C2jsContext *parent, Shard *shard)
+{
+    C2jsContext *ctx = shard->ctx;
+    reset_translation(ctx);
+    ctx->traceLevel = parent->traceLevel;
+    ctx->source = parent->source;
+    ctx->tokens = parent->tokens;
+    ctx->lines = parent->lines;
+    ctx->firstLine = parent->firstLine;
+    ctx->firstColumn = parent->firstColumn;
+    shard->failed = false;
+    if (setjmp(ctx->syntaxError))
+    {
+        shard->failed = true;
+        return;
+    }
+    ctx->currentToken = shard->start;
+    ctx->parseEnd = shard->end;
+    ctx->ast.root = node_here(ctx, NODE_PROGRAM);
+    program(ctx);
+    shard->failed = ctx->currentToken != shard->end;
+}
+
+static void shard_check(C2jsContext *parent, Shard *shard)
+{
+    C2jsContext *ctx = shard->ctx;
+    for (size_t i = 0; i < shard->visibleNames; i++)
+    {
+        symtab_declare(&ctx->symbols, parent->topNames[2 * i], parent->topNames[2 * i + 1]);
+    }
+    shard->semanticErrors = semantic_analysis(ctx);
+}
+
+static void shard_emit(Shard *shard)
+{
+    sink_reset(&shard->output);
+    emit_node(shard->ctx, &shard->output, shard->ctx->ast.root);
+}
+
+static void *shard_worker(void *arg)
+{
+    ShardQueue *queue = arg;
+    for (int next = atomic_fetch_add(&queue->next, 1); next < queue->shardCount; next = atomic_fetch_add(&queue->next, 1))
+    {
+        Shard *shard = &queue->parent->shards[next];
+        if (queue->phase == SHARD_PARSE)
+        {
+            shard_parse(queue->parent, shard);
+        }
+        else if (queue->phase == SHARD_CHECK)
+        {
+            shard_check(queue->parent, shard);
+        }
+        else
+        {
+            shard_emit(shard);
+        }
+    }
+    return NULL;
+}
+
+// Runs phase over every shard on ctx->threads threads, this one included.
+static void run_shards(C2jsContext *ctx, int shardCount, ShardPhase phase)
+{
+    for (int i = 0; i < shardCount; i++)
+    {
+        shard_log_begin(&ctx->shards[i]);
+    }
+    ShardQueue queue = {.parent = ctx, .shardCount = shardCount, .phase = phase};
+    atomic_init(&queue.next, 0);
+    int helpers = (ctx->threads < shardCount ? ctx->threads : shardCount) - 1;
+    pthread_t *threads = malloc(sizeof(pthread_t) * (helpers > 0 ? helpers : 1));
+    int started = 0;
+    while (started < helpers && pthread_create(&threads[started], NULL, shard_worker, &queue) == 0)
+    {
+        started++;
+    }
+    shard_worker(&queue);
+    for (int i = 0; i < started; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    free(threads);
+}
+
+static void add_top_name(C2jsContext *ctx, uint32_t name, uint32_t type)
+{
+    if (ctx->topNameCount == ctx->topNameCapacity)
+    {
+        ctx->topNameCapacity = ctx->topNameCapacity ? ctx->topNameCapacity * 2 : 1024;
+        ctx->topNames = realloc(ctx->topNames, sizeof(uint32_t) * 2 * ctx->topNameCapacity);
+        if (!ctx->topNames)
+        {
+            perror("Failed to allocate top-level names");
+            exit(EXIT_FAILURE);
+        }
+    }
+    ctx->topNames[2 * ctx->topNameCount] = name;
+    ctx->topNames[2 * ctx->topNameCount + 1] = type;
+    ctx->topNameCount++;
+}
+
+// The names each top-level declaration adds to the outermost scope, in the
+// order check_node() would declare them.
+static void gather_top_names(C2jsContext *ctx, int shardCount)
+{
+    ctx->topNameCount = 0;
+    for (int i = 0; i < shardCount; i++)
+    {
+        Shard *shard = &ctx->shards[i];
+        shard->visibleNames = ctx->topNameCount;
+        const C2jsContext *part = shard->ctx;
+        for (uint32_t child = part->ast.nodes[part->ast.root].firstChild; child != AST_NONE; child = part->ast.nodes[child].nextSibling)
+        {
+            const AstNode *node = &part->ast.nodes[child];
+            if (node->kind == NODE_FUNCTION)
+            {
+                add_top_name(ctx, ctx->tokens.ids[node->token], ctx->tokens.ids[node->token - 1]);
+            }
+            else if (node->kind == NODE_DECLARATION)
+            {
+                for (uint32_t declarator = node->firstChild; declarator != AST_NONE; declarator = part->ast.nodes[declarator].nextSibling)
+                {
+                    add_top_name(ctx, ctx->tokens.ids[part->ast.nodes[declarator].token], ctx->tokens.ids[node->token]);
+                }
+            }
+        }
+    }
+}
+
+// Parses in parallel. Returns the shard count, or 0 if the input is better
+// left to the sequential parser: small, not cleanly divisible, or with a
+// syntax error, whose report the sequential parser then makes exactly.
+static int parse_parallel(C2jsContext *ctx)
+{
+    if (ctx->threads < 2 || ctx->cache || ctx->tokens.count < PARALLEL_MIN_TOKENS)
+    {
+        return 0;
+    }
+    int shardCount = split_shards(ctx, ctx->threads * 4);
+    if (shardCount < 2)
+    {
+        return 0;
+    }
+    source_lines(ctx);
+    run_shards(ctx, shardCount, SHARD_PARSE);
+    bool failed = false;
+    for (int i = 0; i < shardCount; i++)
+    {
+        failed = failed || ctx->shards[i].failed;
+    }
+    for (int i = 0; i < shardCount; i++)
+    {
+        shard_log_replay(ctx, &ctx->shards[i], !failed);
+    }
+    if (failed)
+    {
+        return 0;
+    }
+    trace(ctx, C2JS_TRACE_INFO, "Parsing successful\n");
+    return shardCount;
+}
+
+static int semantic_analysis_parallel(C2jsContext *ctx, int shardCount)
+{
+    gather_top_names(ctx, shardCount);
+    run_shards(ctx, shardCount, SHARD_CHECK);
+    int semanticErrors = 0;
+    for (int i = 0; i < shardCount; i++)
+    {
+        shard_log_replay(ctx, &ctx->shards[i], true);
+        semanticErrors += ctx->shards[i].semanticErrors;
+    }
+    return semanticErrors;
+}
+
+static void convert_to_javascript_parallel(C2jsContext *ctx, int shardCount, OutputSink *out)
+{
+    run_shards(ctx, shardCount, SHARD_EMIT);
+    for (int i = 0; i < shardCount; i++)
+    {
+        shard_log_replay(ctx, &ctx->shards[i], true);
+        sink_write(out, ctx->shards[i].output.data, ctx->shards[i].output.length);
+    }
+    trace(ctx, C2JS_TRACE_TRACE, "\n");
+    generate_main_function_call(ctx, out);
+}
+
+C2jsResult c2js_translate_buffer(C2jsContext *ctx, const char *source, size_t length, OutputSink *sink)
+{
+    ctx->translationStart = ctx->phaseStart = now_seconds();
+    reset_translation(ctx);
+    ctx->firstLine = ctx->firstColumn = 1;
+    ctx->stats = (C2jsStats){.files = 1, .bytesIn = length};
+    if (length > TOKEN_MAX_SOURCE)
+    {
+        trace(ctx, C2JS_TRACE_ERROR, "Input of %zu bytes exceeds the %zu byte limit\n", length, TOKEN_MAX_SOURCE);
+        return C2JS_TOO_LARGE;
+    }
+
+    // Unchanged files cost a hash and a read, not even tokenizing.
+    CacheKey fileKey = {0};
+    if (ctx->cache)
+    {
+        fileKey = cache_key(source, length, cache_seed(ctx->cache, 1));
+        const char *js;
+        size_t jsLength;
+        double cost;
+        ctx->stats.cacheLookups++;
+        if (cache_get(ctx->cache, fileKey, &ctx->arena, &js, &jsLength, &cost))
+        {
+            trace(ctx, C2JS_TRACE_INFO, "Translation found in cache\n");
+            sink_write(sink, js, jsLength);
+            ctx->stats.bytesOut = jsLength;
+            ctx->stats.cacheHits++;
+            ctx->stats.wallSeconds = now_seconds() - ctx->translationStart;
+            ctx->stats.cacheSecondsSaved += cost - ctx->stats.wallSeconds;
+            return C2JS_OK;
+        }
+    }
+    ctx->source = source;
+    tokenize(&ctx->interner, &ctx->tokenStore, source, length);
+    ctx->tokens = ctx->tokenStore;
+    ctx->stats.tokens = ctx->tokens.count - 1; // not counting T_EOF
+    phase_done(ctx, C2JS_PHASE_TOKENIZE);
+    if (tracing(ctx, C2JS_TRACE_TRACE))
+    {
+        print_tokens(ctx->log, source, &ctx->tokens, source_lines(ctx));
+        ctx->phaseStart = now_seconds();
+    }
+
+    if (setjmp(ctx->syntaxError))
+    {
+        phase_done(ctx, C2JS_PHASE_PARSE);
+        return C2JS_SYNTAX_ERROR;
+    }
+    int shardCount = parse_parallel(ctx);
+    if (shardCount == 0)
+    {
+        parse(ctx);
+    }
+    phase_done(ctx, C2JS_PHASE_PARSE);
+    int semanticErrors = shardCount ? semantic_analysis_parallel(ctx, shardCount) : semantic_analysis(ctx);
+    phase_done(ctx, C2JS_PHASE_SEMANTIC);
+    if (semanticErrors == 0)
+    {
+        trace(ctx, C2JS_TRACE_INFO, "Semantic Analysis: No errors found. Success!\n");
+    }
+    else
+    {
+        trace(ctx, C2JS_TRACE_ERROR, "Semantic Analysis: %d errors found.\n", semanticErrors);
+        return C2JS_SEMANTIC_ERROR;
+    }
+
+    size_t outputStart = sink_total(sink);
+    if (ctx->cache)
+    {
+        convert_to_javascript_cached(ctx, sink, fileKey);
+    }
+    else if (shardCount)
+    {
+        convert_to_javascript_parallel(ctx, shardCount, sink);
+    }
+    else
+    {
+        convert_to_javascript_with_main_call(ctx, sink);
+    }
+    ctx->stats.bytesOut = sink_total(sink) - outputStart;
+    phase_done(ctx, C2JS_PHASE_CODEGEN);
+    return C2JS_OK;
+}
+
+// Streaming translation. The input is read into a window that begins at the
+// first top-level declaration not yet translated. Whenever more arrives, the
+// window is lexed up to its last complete lexeme and cut after its last
+// complete top-level declaration, delimited as split_shards() delimits them.
+// Those declarations are parsed, checked and emitted like a shard, and are
+// then dropped from the window together with their tokens, tree and interned
+// lexemes. Only the top-level names are kept, in a global scope that lasts
+// the whole stream and that check_use() falls back on, so memory follows the
+// largest declaration and the number of top-level names rather than the
+// file. The parser looks ahead and emits by token index, so it reads the
+// window's tokens by index rather than pulling them from a ring.
+
+// Bytes asked of each read().
+#define STREAM_CHUNK (64 * 1024)
+
+typedef struct
+{
+    int fd;
+    char *data; // the window
+    size_t length;
+    size_t capacity;
+    size_t bytesRead;
+    bool ended; // read() returned 0
+    int line;   // where data starts in the input
+    int column;
+    int semanticErrors;
+} Stream;
+
+// Reads until the window holds wanted bytes or the input ends.
+static bool stream_fill(Stream *stream, size_t wanted)
+{
+    while (stream->length < wanted && !stream->ended)
+    {
+        if (stream->capacity - stream->length < STREAM_CHUNK)
+        {
+            size_t capacity = stream->length + STREAM_CHUNK > stream->capacity * 2 ? stream->length + STREAM_CHUNK : stream->capacity * 2;
+            char *grown = realloc(stream->data, capacity);
+            if (!grown)
+            {
+                perror("Failed to grow the stream window");
+                exit(EXIT_FAILURE);
+            }
+            stream->data = grown;
+            stream->capacity = capacity;
+        }
+        ssize_t count = read(stream->fd, stream->data + stream->length, STREAM_CHUNK);
+        if (count < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (count < 0)
+        {
+            return false;
+        }
+        stream->ended = count == 0;
+        stream->length += count;
+        stream->bytesRead += count;
+    }
+    return true;
+}
+
+// Drops the first cut bytes of the window, keeping track of where it starts.
+static void stream_drop(Stream *stream, size_t cut)
+{
+    size_t newlines = scan_count(stream->data, stream->data + cut, '\n');
+    if (newlines > 0)
+    {
+        const char *last = stream->data + cut;
+        while (*--last != '\n')
+        {
+        }
+        stream->line += newlines;
+        stream->column = (int)(stream->data + cut - last);
+    }
+    else
+    {
+        stream->column += cut;
+    }
+    memmove(stream->data, stream->data + cut, stream->length - cut);
+    stream->length -= cut;
+}
+
+// Interns text into the global scope, copying it on first sight.
+static uint32_t global_intern(GlobalScope *globals, const char *text, size_t length)
+{
+    uint32_t id = intern_find(&globals->interner, text, length);
+    return id != INTERN_NONE ? id : intern(&globals->interner, arena_strndup(&globals->arena, text, length), length);
+}
+
+static void global_declare(GlobalScope *globals, const C2jsContext *ctx, uint32_t name, uint32_t type)
+{
+    symtab_declare(&globals->symbols, global_intern(globals, token_text(ctx->source, &ctx->tokens, name), ctx->tokens.lengths[name]),
+                   global_intern(globals, token_text(ctx->source, &ctx->tokens, type), ctx->tokens.lengths[type]));
+}
+
+// Adds the names the window's declarations add to the outermost scope to
+// the global scope, which check_use() falls back on for later windows.
+static void stream_keep_names(GlobalScope *globals, const C2jsContext *ctx)
+{
+    for (uint32_t child = ctx->ast.nodes[ctx->ast.root].firstChild; child != AST_NONE; child = ctx->ast.nodes[child].nextSibling)
+    {
+        const AstNode *node = &ctx->ast.nodes[child];
+        if (node->kind == NODE_FUNCTION)
+        {
+            global_declare(globals, ctx, node->token, node->token - 1);
+        }
+        else if (node->kind == NODE_DECLARATION)
+        {
+            for (uint32_t declarator = node->firstChild; declarator != AST_NONE; declarator = ctx->ast.nodes[declarator].nextSibling)
+            {
+                global_declare(globals, ctx, ctx->ast.nodes[declarator].token, node->token);
+            }
+        }
+    }
+}
+
+// print_tokens() for the first count tokens, with lines counted from the
+// start of the input rather than of the window.
+static void trace_tokens(C2jsContext *ctx, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        trace(ctx, C2JS_TRACE_TRACE, "<%s, %.*s, %d>\n", token_type_strings[ctx->tokens.types[i]], TOKEN_TEXT(ctx->source, ctx->tokens, i), token_line(ctx, i));
+    }
+}
+
+// The token after the last complete top-level declaration of a partially
+// lexed window, or 0 if there is none.
+static int complete_declarations_end(C2jsContext *ctx)
+{
+    int eof = ctx->tokens.count - 1;
+    int end = 0;
+    while (end < eof)
+    {
+        int next = declaration_end(ctx, end);
+        if (next < 0)
+        {
+            break;
+        }
+        end = next;
+    }
+    return end;
+}
+
+// Translates the complete top-level declarations at the start of the
+// window, or all of it once the input has ended. *cut is the number of bytes
+// translated: 0 if more input is needed first.
+static C2jsResult stream_window(C2jsContext *ctx, Stream *stream, OutputSink *sink, size_t *cut)
+{
+    bool final = stream->ended;
+    reset_translation(ctx);
+    ctx->source = stream->data;
+    ctx->firstLine = stream->line;
+    ctx->firstColumn = stream->column;
+    if (final)
+    {
+        tokenize(&ctx->interner, &ctx->tokenStore, stream->data, stream->length);
+    }
+    else
+    {
+        tokenize_partial(&ctx->interner, &ctx->tokenStore, stream->data, stream->length);
+    }
+    ctx->tokens = ctx->tokenStore;
+    phase_done(ctx, C2JS_PHASE_TOKENIZE);
+
+    int end = final ? ctx->tokens.count - 1 : complete_declarations_end(ctx);
+    if (!final && end == 0)
+    {
+        *cut = 0;
+        return C2JS_OK;
+    }
+
+    // A parse that fails before the input has ended may only need more of
+    // it, so its log is held back until it is known to stand.
+    FILE *log = ctx->log;
+    char *logText = NULL;
+    size_t logLength = 0;
+    FILE *held = final ? NULL : open_memstream(&logText, &logLength);
+    ctx->log = held ? held : log;
+    if (tracing(ctx, C2JS_TRACE_TRACE))
+    {
+        trace_tokens(ctx, final ? end + 1 : end);
+        ctx->phaseStart = now_seconds();
+    }
+    bool failed = true;
+    if (!setjmp(ctx->syntaxError))
+    {
+        ctx->currentToken = 0;
+        ctx->parseEnd = end;
+        ctx->ast.root = node_here(ctx, NODE_PROGRAM);
+        program(ctx);
+        failed = ctx->currentToken != end;
+    }
+    // An error inside the complete declarations stands whatever follows.
+    bool stands = !failed || final || ctx->currentToken < end;
+    ctx->log = log;
+    if (held)
+    {
+        fclose(held);
+        if (stands)
+        {
+            fwrite(logText, 1, logLength, log);
+        }
+        free(logText);
+    }
+    phase_done(ctx, C2JS_PHASE_PARSE);
+    if (failed)
+    {
+        *cut = 0;
+        return stands ? C2JS_SYNTAX_ERROR : C2JS_OK;
+    }
+
+    ctx->stats.tokens += end;
+    stream->semanticErrors += semantic_analysis(ctx);
+    phase_done(ctx, C2JS_PHASE_SEMANTIC);
+    // As from c2js_translate_buffer(), there is no output after an error.
+    if (stream->semanticErrors == 0)
+    {
+        emit_node(ctx, sink, ctx->ast.root);
+        sink_flush(sink);
+    }
+    phase_done(ctx, C2JS_PHASE_CODEGEN);
+    stream_keep_names(ctx->globals, ctx);
+    // Each delimited declaration ends in a '}', a ';' or a directive, whose
+    // token is all of its lexeme.
+    *cut = final ? stream->length : ctx->tokens.offsets[end - 1] + ctx->tokens.lengths[end - 1];
+    return C2JS_OK;
+}
+
+C2jsResult c2js_translate_stream(C2jsContext *ctx, int fd, OutputSink *sink)
+{
+    ctx->translationStart = ctx->phaseStart = now_seconds();
+    ctx->stats = (C2jsStats){.files = 1};
+    C2jsCache *cache = ctx->cache;
+    ctx->cache = NULL;
+    Stream stream = {.fd = fd, .line = 1, .column = 1};
+    GlobalScope globals;
+    arena_init(&globals.arena);
+    interner_init(&globals.interner, &globals.arena);
+    symtab_init(&globals.symbols, &globals.arena);
+    ctx->globals = &globals;
+    size_t outputStart = sink_total(sink);
+
+    // Each window is lexed again from its start, so after a window without
+    // a complete declaration the next attempt waits for twice the bytes.
+    C2jsResult result = C2JS_OK;
+    size_t wanted = 1;
+    for (;;)
+    {
+        if (!stream_fill(&stream, wanted))
+        {
+            trace(ctx, C2JS_TRACE_ERROR, "Failed to read input: %s\n", strerror(errno));
+            result = C2JS_READ_ERROR;
+            break;
+        }
+        if (stream.length > TOKEN_MAX_SOURCE)
+        {
+            trace(ctx, C2JS_TRACE_ERROR, "Unfinished declaration of %zu bytes exceeds the %zu byte limit\n", stream.length, TOKEN_MAX_SOURCE);
+            result = C2JS_TOO_LARGE;
+            break;
+        }
+        size_t cut;
+        result = stream_window(ctx, &stream, sink, &cut);
+        if (result != C2JS_OK || stream.ended)
+        {
+            break;
+        }
+        stream_drop(&stream, cut);
+        wanted = cut > 0 ? stream.length + 1 : stream.length * 2 + 1;
+    }
+    ctx->stats.bytesIn = stream.bytesRead;
+
+    if (result == C2JS_OK)
+    {
+        trace(ctx, C2JS_TRACE_INFO, "Parsing successful\n");
+        if (stream.semanticErrors == 0)
+        {
+            trace(ctx, C2JS_TRACE_INFO, "Semantic Analysis: No errors found. Success!\n");
+            trace(ctx, C2JS_TRACE_TRACE, "\n");
+            generate_main_function_call(ctx, sink);
+            sink_flush(sink);
+        }
+        else
+        {
+            trace(ctx, C2JS_TRACE_ERROR, "Semantic Analysis: %d errors found.\n", stream.semanticErrors);
+            result = C2JS_SEMANTIC_ERROR;
+        }
+    }
+    ctx->stats.bytesOut = sink_total(sink) - outputStart;
+    ctx->stats.wallSeconds = now_seconds() - ctx->translationStart;
+    ctx->cache = cache;
+    ctx->globals = NULL;
+    arena_free(&globals.arena);
+    free(stream.data);
+    return result;
+}
+
+const C2jsStats *c2js_last_stats(const C2jsContext *ctx)
+{
+    return &ctx->stats;
+}
+
+void c2js_stats_add(C2jsStats *total, const C2jsStats *stats)
+{
+    for (int phase = 0; phase < C2JS_PHASE_COUNT; phase++)
+    {
+        total->phaseSeconds[phase] += stats->phaseSeconds[phase];
+    }
+    total->wallSeconds += stats->wallSeconds;
+    total->files += stats->files;
+    total->tokens += stats->tokens;
+    total->bytesIn += stats->bytesIn;
+    total->bytesOut += stats->bytesOut;
+    total->cacheLookups += stats->cacheLookups;
+    total->cacheHits += stats->cacheHits;
+    total->cacheSecondsSaved += stats->cacheSecondsSaved;
+}
+
+void c2js_stats_print(FILE *out, const C2jsStats *stats, C2jsStatsFormat format)
+{
+    static const char *phaseNames[C2JS_PHASE_COUNT] = {"tokenize", "parse", "semantic", "codegen"};
+    double busy = 0;
+    for (int phase = 0; phase < C2JS_PHASE_COUNT; phase++)
+    {
+        busy += stats->phaseSeconds[phase];
+    }
+    double tokensPerSecond = busy > 0 ? stats->tokens / busy : 0;
+    double megabytesPerSecond = busy > 0 ? stats->bytesIn / busy / 1e6 : 0;
+    double hitRate = stats->cacheLookups > 0 ? (double)stats->cacheHits / stats->cacheLookups : 0;
+
+    if (format == C2JS_STATS_JSON)
+    {
+        fprintf(out, "{\"files\":%zu,\"tokens\":%zu,\"bytes_in\":%zu,\"bytes_out\":%zu,\"seconds\":{",
+                stats->files, stats->tokens, stats->bytesIn, stats->bytesOut);
+        for (int phase = 0; phase < C2JS_PHASE_COUNT; phase++)
+        {
+            fprintf(out, "\"%s\":%.9f,", phaseNames[phase], stats->phaseSeconds[phase]);
+        }
+        fprintf(out, "\"total\":%.9f},\"wall_seconds\":%.9f,\"tokens_per_second\":%.1f,\"mb_per_second\":%.3f,"
+                     "\"cache\":{\"lookups\":%zu,\"hits\":%zu,\"hit_rate\":%.4f,\"seconds_saved\":%.9f}}\n",
+                busy, stats->wallSeconds, tokensPerSecond, megabytesPerSecond, stats->cacheLookups, stats->cacheHits, hitRate,
+                stats->cacheSecondsSaved);
+        return;
+    }
+
+    fprintf(out, "%-10s %12s %7s\n", "phase", "seconds", "share");
+    for (int phase = 0; phase < C2JS_PHASE_COUNT; phase++)
+    {
+        fprintf(out, "%-10s %12.6f %6.1f%%\n", phaseNames[phase], stats->phaseSeconds[phase],
+                busy > 0 ? stats->phaseSeconds[phase] / busy * 100 : 0.0);
+    }
+    fprintf(out, "%-10s %12.6f\n", "total", busy);
+    fprintf(out, "%zu files, %zu tokens, %zu bytes in, %zu bytes out, %.6f s wall\n",
+            stats->files, stats->tokens, stats->bytesIn, stats->bytesOut, stats->wallSeconds);
+    fprintf(out, "%.0f tokens/s, %.2f MB/s\n", tokensPerSecond, megabytesPerSecond);
+    if (stats->cacheLookups > 0)
+    {
+        fprintf(out, "cache: %zu of %zu lookups hit (%.1f%%), %.6f s saved\n", stats->cacheHits, stats->cacheLookups, hitRate * 100,
+                stats->cacheSecondsSaved);
+    }
+}
@@ -0,0 +1,122 @@
+#ifndef LIBC2JS_H
+#define LIBC2JS_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include "output_sink.h"
+
+// C to JavaScript translation as a library. A context owns all pipeline state
+// (tokens, symbols, arena) and is reused across translations; use one context
+// per thread to translate concurrently.
+
+typedef struct C2jsContext C2jsContext;
+
+typedef enum
+{
+    C2JS_OK,
+    C2JS_SYNTAX_ERROR,
+    C2JS_SEMANTIC_ERROR,
+    C2JS_TOO_LARGE, // more than 2 GiB of source in one buffer
+    C2JS_READ_ERROR // c2js_translate_stream() could not read its input
+} C2jsResult;
+
+// How much goes to the log. Each level includes the ones before it.
+typedef enum
+{
+    C2JS_TRACE_OFF,
+    C2JS_TRACE_ERROR, // syntax and semantic errors
+    C2JS_TRACE_INFO,  // plus the outcome of each phase
+    C2JS_TRACE_TRACE  // plus the token dump and every parser step
+} C2jsTraceLevel;
+
+C2jsContext *c2js_context_new(void);
+void c2js_context_free(C2jsContext *ctx);
+
+// Where token dumps, parse traces and diagnostics go (stdout by default).
+void c2js_set_log(C2jsContext *ctx, FILE *log);
+
+// C2JS_TRACE_INFO by default. Levels above C2JS_TRACE_MAX (see libc2js.c)
+// are compiled out and cannot be enabled at run time.
+void c2js_set_trace_level(C2jsContext *ctx, C2jsTraceLevel level);
+
+// Translates length bytes of C source and writes the JavaScript to sink,
+// which may target a file descriptor (a file, stdout) or memory; the caller
+// flushes or reads it afterwards. Nothing is written to sink unless the
+// result is C2JS_OK. source need not be NUL-terminated; it is referenced,
+// not copied, so it must stay valid for the duration of the call.
+C2jsResult c2js_translate_buffer(C2jsContext *ctx, const char *source, size_t length, OutputSink *sink);
+
+// Translates the C source read from fd up to end of file, writing each
+// top-level declaration's JavaScript to sink, and flushing it, as soon as
+// the declaration has been read and checked. Memory follows the largest
+// declaration and the number of top-level names rather than the input.
+// Output and log lines are those of c2js_translate_buffer(), except that
+// each declaration is logged as it is translated, and that after an error
+// sink keeps the output of the declarations before it. The cache and threads are not used.
+C2jsResult c2js_translate_stream(C2jsContext *ctx, int fd, OutputSink *sink);
+
+// Splits each translation of a large input at its top-level declarations
+// and parses, checks and emits the parts on up to threads threads. The
+// output and log are the same as with one thread (the default). Inputs under
+// 64k tokens, and translations with a cache, are not split.
+void c2js_set_threads(C2jsContext *ctx, int threads);
+
+// On-disk cache of translations in dir (created if missing), trimmed to
+// about maxBytes by evicting the least recently used entries. Whole files
+// and single top-level functions are cached, so an edit to one function
+// reuses the others. One cache may be shared by contexts on any number of
+// threads, and a directory by any number of processes. Returns NULL if dir
+// cannot be created.
+typedef struct C2jsCache C2jsCache;
+C2jsCache *c2js_cache_open(const char *dir, size_t maxBytes);
+// Trims the cache to its cap and frees the handle.
+void c2js_cache_close(C2jsCache *cache);
+// Looks translations up in cache and stores new ones there; NULL (the
+// default) disables caching. The cache must outlive its use by ctx.
+void c2js_set_cache(C2jsContext *ctx, C2jsCache *cache);
+
+// Line and byte column (both from 1) of the token that stopped the parser
+// after a C2JS_SYNTAX_ERROR.
+int c2js_error_line(const C2jsContext *ctx);
+int c2js_error_column(const C2jsContext *ctx);
+
+typedef enum
+{
+    C2JS_PHASE_TOKENIZE,
+    C2JS_PHASE_PARSE,
+    C2JS_PHASE_SEMANTIC,
+    C2JS_PHASE_CODEGEN,
+    C2JS_PHASE_COUNT
+} C2jsPhase;
+
+// What a translation did and how long each phase took (monotonic clock).
+// Phases a failed translation never reached take 0 s. Stats of several
+// translations add up with c2js_stats_add(); rates are derived from the
+// totals when printed, never averaged.
+typedef struct
+{
+    double phaseSeconds[C2JS_PHASE_COUNT];
+    double wallSeconds; // the whole call; a batch sets its elapsed time
+    size_t files;
+    size_t tokens;
+    size_t bytesIn;
+    size_t bytesOut;
+    size_t cacheLookups; // whole files and single functions
+    size_t cacheHits;
+    // Recorded cost of producing each hit, less the time spent reading it.
+    double cacheSecondsSaved;
+} C2jsStats;
+
+typedef enum
+{
+    C2JS_STATS_TEXT,
+    C2JS_STATS_JSON // one object on one line
+} C2jsStatsFormat;
+
+// Stats of the last c2js_translate_buffer() or c2js_translate_stream() call
+// on ctx.
+const C2jsStats *c2js_last_stats(const C2jsContext *ctx);
+void c2js_stats_add(C2jsStats *total, const C2jsStats *stats);
+void c2js_stats_print(FILE *out, const C2jsStats *stats, C2jsStatsFormat format);
+
+#endif
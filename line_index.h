@@ -0,0 +1,70 @@
+#ifndef LINE_INDEX_H
+#define LINE_INDEX_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "scan.h"
+
+// The offset at which each line of a source starts, so that the line and
+// column of any byte are a binary search away. Nothing is tracked while
+// lexing: the index is built in one pass over the whole source, with the
+// scan.h kernels, the first time a position is asked for. Lines end at '\n'
+// wherever it appears, inside comments and string literals too. Columns
+// count bytes from 1.
+
+typedef struct
+{
+    uint32_t *starts; // starts[0] is 0, then one past each '\n'
+    uint32_t count;   // lines, or 0 before line_index_build()
+    uint32_t capacity;
+} LineIndex;
+
+static void line_index_build(LineIndex *index, const char *source, size_t length)
+{
+    size_t lines = scan_count(source, source + length, '\n') + 1;
+    if (index->capacity < lines)
+    {
+        uint32_t *starts = realloc(index->starts, sizeof(uint32_t) * lines);
+        if (!starts)
+        {
+            perror("Failed to grow the line index");
+            exit(EXIT_FAILURE);
+        }
+        index->starts = starts;
+        index->capacity = (uint32_t)lines;
+    }
+    index->starts[0] = 0;
+    scan_offsets_after(source, source + length, '\n', source, index->starts + 1);
+    index->count = (uint32_t)lines;
+}
+
+// The 1-based line holding the byte at offset; *column is its 1-based byte
+// column.
+static int line_index_find(const LineIndex *index, uint32_t offset, int *column)
+{
+    uint32_t low = 1;
+    uint32_t high = index->count;
+    while (low < high)
+    {
+        uint32_t middle = low + (high - low) / 2;
+        if (index->starts[middle] <= offset)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    *column = (int)(offset - index->starts[low - 1]) + 1;
+    return (int)low;
+}
+
+static void line_index_free(LineIndex *index)
+{
+    free(index->starts);
+    *index = (LineIndex){0};
+}
+
+#endif
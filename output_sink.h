@@ -0,0 +1,182 @@
+#ifndef OUTPUT_SINK_H
+#define OUTPUT_SINK_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// Buffered byte sink for generated code. Output is memcpy'd into one large
+// owned buffer with no format parsing or stream locking. A file-descriptor
+// sink flushes it with write() when full, and hands slices larger than the
+// buffer to writev() together with the pending bytes instead of copying
+// them. A memory sink (fd -1) keeps growing the buffer and never flushes,
+// which is how the library API returns output in memory.
+
+#define OUTPUT_SINK_BUFFER (256 * 1024)
+
+typedef struct
+{
+    char *data;
+    size_t length;
+    size_t capacity;
+    size_t flushed; // bytes already handed to fd
+    int fd;         // destination, or -1 for a memory sink
+    bool failed;    // a write failed; later output is dropped
+} OutputSink;
+
+static void sink_init_fd(OutputSink *sink, int fd)
+{
+    sink->data = malloc(OUTPUT_SINK_BUFFER);
+    if (!sink->data)
+    {
+        perror("Failed to allocate output buffer");
+        exit(EXIT_FAILURE);
+    }
+    sink->length = 0;
+    sink->capacity = OUTPUT_SINK_BUFFER;
+    sink->flushed = 0;
+    sink->fd = fd;
+    sink->failed = false;
+}
+
+static void sink_init_memory(OutputSink *sink)
+{
+    sink_init_fd(sink, -1);
+}
+
+// Writes all of iov[0..count), retrying after short writes and EINTR.
+static bool sink_writev_all(int fd, struct iovec *iov, int count)
+{
+    while (count > 0)
+    {
+        ssize_t written = writev(fd, iov, count);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        while (count > 0 && (size_t)written >= iov->iov_len)
+        {
+            written -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0)
+        {
+            iov->iov_base = (char *)iov->iov_base + written;
+            iov->iov_len -= written;
+        }
+    }
+    return true;
+}
+
+static bool sink_flush(OutputSink *sink)
+{
+    if (sink->fd >= 0 && sink->length > 0 && !sink->failed)
+    {
+        struct iovec iov = {sink->data, sink->length};
+        sink->failed = !sink_writev_all(sink->fd, &iov, 1);
+    }
+    if (sink->fd >= 0)
+    {
+        sink->flushed += sink->length;
+        sink->length = 0;
+    }
+    return !sink->failed;
+}
+
+// Slow path of sink_write(): the bytes do not fit in the buffer.
+static void sink_overflow(OutputSink *sink, const char *bytes, size_t length)
+{
+    if (sink->fd < 0)
+    {
+        while (sink->capacity < sink->length + length)
+        {
+            sink->capacity *= 2;
+        }
+        char *grown = realloc(sink->data, sink->capacity);
+        if (!grown)
+        {
+            perror("Failed to grow output buffer");
+            exit(EXIT_FAILURE);
+        }
+        sink->data = grown;
+    }
+    else if (length >= sink->capacity)
+    {
+        struct iovec iov[2] = {{sink->data, sink->length}, {(char *)bytes, length}};
+        sink->failed = sink->failed || !sink_writev_all(sink->fd, iov, 2);
+        sink->flushed += sink->length + length;
+        sink->length = 0;
+        return;
+    }
+    else
+    {
+        sink_flush(sink);
+    }
+    memcpy(sink->data + sink->length, bytes, length);
+    sink->length += length;
+}
+
+static void sink_write(OutputSink *sink, const char *bytes, size_t length)
+{
+    if (sink->length + length > sink->capacity)
+    {
+        sink_overflow(sink, bytes, length);
+        return;
+    }
+    memcpy(sink->data + sink->length, bytes, length);
+    sink->length += length;
+}
+
+// Everything written so far, flushed or not.
+static size_t sink_total(const OutputSink *sink)
+{
+    return sink->flushed + sink->length;
+}
+
+// Constant snippets: the length is a compile-time constant.
+#define sink_literal(sink, text) sink_write((sink), (text), sizeof(text) - 1)
+
+// Empties a memory sink for reuse, keeping its buffer.
+static void sink_reset(OutputSink *sink)
+{
+    sink->length = 0;
+    sink->flushed = 0;
+    sink->failed = false;
+}
+
+// Writes the contents of a memory sink to path, replacing the file.
+static bool sink_save(const OutputSink *sink, const char *path)
+{
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0)
+    {
+        return false;
+    }
+    struct iovec iov = {sink->data, sink->length};
+    bool ok = sink_writev_all(fd, &iov, 1);
+    return close(fd) == 0 && ok;
+}
+
+// Flushes and releases the buffer; the fd is left open. Returns false if
+// any write failed.
+static bool sink_close(OutputSink *sink)
+{
+    bool ok = sink_flush(sink);
+    free(sink->data);
+    sink->data = NULL;
+    sink->length = 0;
+    sink->capacity = 0;
+    return ok;
+}
+
+#endif
@@ -2,6 +2,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include "source.h"
+#include "punctuators.h"
 
 typedef enum
 {
@@ -24,13 +26,17 @@ typedef enum
     TOKEN_UNKNOWN
 } TokenType;
 
+// A token is a slice of the mapped source; EOF has no text.
 typedef struct
 {
     TokenType type;
-    char *value;
+    int offset;
+    int length;
     int line_no;
 } Token;
 
+#include "token_vector.h"
+
 const char *token_type_strings[] = {
     "NUMBER",
     "ID",
@@ -51,7 +57,6 @@ const char *token_type_strings[] = {
     "UNKNOWN"};
 
 const char *keywords[] = {"int", "float", "char", "double", "void", "if", "else", "for", "while", "return", "include", "define"};
-const char *operators[] = {"+", "-", "*", "/", "%", "=", "==", "!=", "<", ">", "<=", ">=", "&&", "||", "!", "&", "|", "^", "~", "<<", ">>", "++", "--"};
 
 Token get_next_token();
 Token peek_next_token();
@@ -75,24 +80,36 @@ void while_statement();
 Token *tokens;
 int current_token = 0;
 int token_count = 0;
+SourceFile source;
 
-int is_keyword(const char *str)
+int slice_equals(const char *text, int length, const char *word)
 {
-    for (int i = 0; i < sizeof(keywords) / sizeof(keywords[0]); i++)
+    return strlen(word) == (size_t)length && memcmp(text, word, length) == 0;
+}
+
+int token_is(Token token, const char *word)
+{
+    return slice_equals(source.data + token.offset, token.length, word);
+}
+
+// Prints the token as <TYPE, text>, with "null" for EOF.
+void print_token(Token token)
+{
+    if (token.type == TOKEN_EOF)
     {
-        if (strcmp(str, keywords[i]) == 0)
-        {
-            return 1;
-        }
+        printf("<%s, null>", token_type_strings[token.type]);
+    }
+    else
+    {
+        printf("<%s, %.*s>", token_type_strings[token.type], token.length, source.data + token.offset);
     }
-    return 0;
 }
 
-int is_operator(char c)
+int is_keyword(const char *str, int length)
 {
-    for (int i = 0; i < sizeof(operators) / sizeof(operators[0]); i++)
+    for (int i = 0; i < sizeof(keywords) / sizeof(keywords[0]); i++)
     {
-        if (strchr(operators[i], c))
+        if (slice_equals(str, length, keywords[i]))
         {
             return 1;
         }
@@ -100,39 +117,44 @@ int is_operator(char c)
     return 0;
 }
 
-Token *tokenize(const char *code, int *token_count)
+// Brackets, ';' and ',' are matched before this is asked; every other
+// punctuator character starts an operator.
+int is_operator(char c)
+{
+    return char_class[(unsigned char)c] >= CC_PUNCT;
+}
+
+Token *tokenize(const char *code, size_t length, int *token_count)
 {
-    Token *tokens = malloc(sizeof(Token) * 2048); // Example size, adjust as needed
-    *token_count = 0;
+    TokenVector tokens;
+    token_vector_init(&tokens, length);
     int line_no = 1;
 
-    for (int i = 0; i < strlen(code); i++)
+    for (int i = 0; i < length; i++)
     {
         char c = code[i];
         if (isdigit(c))
         {
             // Handle numbers
             int start = i;
-            while (isdigit(code[i]))
+            while (i < length && isdigit(code[i]))
                 i++;
-            char *num = strndup(code + start, i - start);
-            tokens[(*token_count)++] = (Token){TOKEN_NUMBER, num, line_no};
+            token_vector_push(&tokens, (Token){TOKEN_NUMBER, start, i - start, line_no});
             i--;
         }
         else if (isalpha(c) || c == '_')
         {
             // Handle identifiers and keywords
             int start = i;
-            while (isalnum(code[i]) || code[i] == '_')
+            while (i < length && (isalnum(code[i]) || code[i] == '_'))
                 i++;
-            char *id = strndup(code + start, i - start);
-            if (is_keyword(id))
+            if (is_keyword(code + start, i - start))
             {
-                tokens[(*token_count)++] = (Token){TOKEN_KEYWORD, id, line_no};
+                token_vector_push(&tokens, (Token){TOKEN_KEYWORD, start, i - start, line_no});
             }
             else
             {
-                tokens[(*token_count)++] = (Token){TOKEN_ID, id, line_no};
+                token_vector_push(&tokens, (Token){TOKEN_ID, start, i - start, line_no});
             }
             i--;
         }
@@ -140,61 +162,58 @@ Token *tokenize(const char *code, int *token_count)
         {
             // Handle string literals
             int start = ++i;
-            while (code[i] != '"')
+            while (i < length && code[i] != '"')
                 i++;
-            char *str = strndup(code + start, i - start);
-            tokens[(*token_count)++] = (Token){TOKEN_STRING, str, line_no};
+            token_vector_push(&tokens, (Token){TOKEN_STRING, start, i - start, line_no});
         }
         else if (c == '\'')
         {
             // Handle char literals
             int start = ++i;
-            while (code[i] != '\'')
+            while (i < length && code[i] != '\'')
                 i++;
-            char *ch = strndup(code + start, i - start);
-            tokens[(*token_count)++] = (Token){TOKEN_CHAR, ch, line_no};
+            token_vector_push(&tokens, (Token){TOKEN_CHAR, start, i - start, line_no});
         }
         else if (c == '#')
         {
             // Handle preprocessor directives
             int start = i;
-            while (code[i] != '\n' && code[i] != '\0')
+            while (i < length && code[i] != '\n')
                 i++;
-            char *directive = strndup(code + start, i - start);
-            tokens[(*token_count)++] = (Token){TOKEN_PREPROCESSOR, directive, line_no};
+            token_vector_push(&tokens, (Token){TOKEN_PREPROCESSOR, start, i - start, line_no});
             line_no++;
         }
         else if (c == '(')
         {
-            tokens[(*token_count)++] = (Token){TOKEN_LPAREN, strndup("(", 1), line_no};
+            token_vector_push(&tokens, (Token){TOKEN_LPAREN, i, 1, line_no});
         }
         else if (c == ')')
         {
-            tokens[(*token_count)++] = (Token){TOKEN_RPAREN, strndup(")", 1), line_no};
+            token_vector_push(&tokens, (Token){TOKEN_RPAREN, i, 1, line_no});
         }
         else if (c == '{')
         {
-            tokens[(*token_count)++] = (Token){TOKEN_LBRACE, strndup("{", 1), line_no};
+            token_vector_push(&tokens, (Token){TOKEN_LBRACE, i, 1, line_no});
         }
         else if (c == '}')
         {
-            tokens[(*token_count)++] = (Token){TOKEN_RBRACE, strndup("}", 1), line_no};
+            token_vector_push(&tokens, (Token){TOKEN_RBRACE, i, 1, line_no});
         }
         else if (c == '[')
         {
-            tokens[(*token_count)++] = (Token){TOKEN_LBRACKET, strndup("[", 1), line_no};
+            token_vector_push(&tokens, (Token){TOKEN_LBRACKET, i, 1, line_no});
         }
         else if (c == ']')
         {
-            tokens[(*token_count)++] = (Token){TOKEN_RBRACKET, strndup("]", 1), line_no};
+            token_vector_push(&tokens, (Token){TOKEN_RBRACKET, i, 1, line_no});
         }
         else if (c == ';')
         {
-            tokens[(*token_count)++] = (Token){TOKEN_SEMICOLON, strndup(";", 1), line_no};
+            token_vector_push(&tokens, (Token){TOKEN_SEMICOLON, i, 1, line_no});
         }
         else if (c == ',')
         {
-            tokens[(*token_count)++] = (Token){TOKEN_COMMA, strndup(",", 1), line_no};
+            token_vector_push(&tokens, (Token){TOKEN_COMMA, i, 1, line_no});
         }
         else if (c == '\n')
         {
@@ -206,53 +225,30 @@ Token *tokenize(const char *code, int *token_count)
         }
         else if (is_operator(c))
         {
-            // Handle operators
-            int start = i;
-            while (is_operator(code[i]))
-                i++;
-            char *op = strndup(code + start, i - start);
-            tokens[(*token_count)++] = (Token){TOKEN_OP, op, line_no};
-            i--;
+            // Handle operators, longest match first
+            size_t operatorLength;
+            punct_munch(code + i, code + length, &operatorLength);
+            token_vector_push(&tokens, (Token){TOKEN_OP, i, operatorLength, line_no});
+            i += operatorLength - 1;
         }
         else
         {
-            tokens[(*token_count)++] = (Token){TOKEN_UNKNOWN, strndup(&c, 1), line_no};
+            token_vector_push(&tokens, (Token){TOKEN_UNKNOWN, i, 1, line_no});
         }
     }
 
-    tokens[(*token_count)++] = (Token){TOKEN_EOF, NULL, line_no};
-    return tokens;
+    token_vector_push(&tokens, (Token){TOKEN_EOF, length, 0, line_no});
+    *token_count = tokens.count;
+    return tokens.data;
 }
 
 void print_tokens(Token *tokens, int token_count)
 {
     for (int i = 0; i < token_count; i++)
     {
-        printf("<%s, %s> line %d\n", token_type_strings[tokens[i].type], tokens[i].value ? tokens[i].value : "null", tokens[i].line_no);
-    }
-}
-
-char *read_file(const char *filename)
-{
-    FILE *file = fopen(filename, "r");
-    if (!file)
-    {
-        perror("Failed to open file");
-        exit(EXIT_FAILURE);
+        print_token(tokens[i]);
+        printf(" line %d\n", tokens[i].line_no);
     }
-    fseek(file, 0, SEEK_END);
-    long length = ftell(file);
-    fseek(file, 0, SEEK_SET);
-    char *buffer = malloc(length + 1);
-    if (!buffer)
-    {
-        perror("Failed to allocate buffer");
-        exit(EXIT_FAILURE);
-    }
-    fread(buffer, 1, length, file);
-    buffer[length] = '\0';
-    fclose(file);
-    return buffer;
 }
 
 // Syntax Analyser Part
@@ -290,7 +286,8 @@ void program()
 
 void external_declaration()
 {
-    printf("<%s, %s> \n", token_type_strings[tokens[current_token].type], tokens[current_token].value ? tokens[current_token].value : "null");
+    print_token(tokens[current_token]);
+    printf(" \n");
     int type = tokens[current_token].type;
     if (type == TOKEN_KEYWORD)
     {
@@ -347,7 +344,8 @@ void declaration()
 void match(TokenType expected)
 {
     printf("From match: \n");
-    printf("<%s, %s> \n", token_type_strings[tokens[current_token].type], tokens[current_token].value ? tokens[current_token].value : "null");
+    print_token(tokens[current_token]);
+    printf(" \n");
     if (tokens[current_token].type == expected)
     {
         current_token++;
@@ -378,18 +376,19 @@ void parameter()
 void statement()
 {
     printf("From statement: \n");
-    printf("<%s, %s> \n", token_type_strings[tokens[current_token].type], tokens[current_token].value ? tokens[current_token].value : "null");
+    print_token(tokens[current_token]);
+    printf(" \n");
     if (tokens[current_token].type == TOKEN_KEYWORD)
     {
-        if (strcmp(tokens[current_token].value, "return") == 0)
+        if (token_is(tokens[current_token], "return"))
         {
             return_statement();
         }
-        else if (strcmp(tokens[current_token].value, "for") == 0)
+        else if (token_is(tokens[current_token], "for"))
         {
             for_statement();
         }
-        else if (strcmp(tokens[current_token].value, "while") == 0)
+        else if (token_is(tokens[current_token], "while"))
         {
             while_statement();
         }
@@ -478,7 +477,7 @@ void term()
 {
     printf("From term: \n");
     factor();
-    while (tokens[current_token].type == TOKEN_OP && (strcmp(tokens[current_token].value, "*") == 0 || strcmp(tokens[current_token].value, "/") == 0))
+    while (tokens[current_token].type == TOKEN_OP && (token_is(tokens[current_token], "*") || token_is(tokens[current_token], "/")))
     {
         match(TOKEN_OP);
         factor();
@@ -488,7 +487,8 @@ void term()
 void factor()
 {
     printf("From factor: \n");
-    printf("<%s, %s> \n", token_type_strings[tokens[current_token].type], tokens[current_token].value ? tokens[current_token].value : "null");
+    print_token(tokens[current_token]);
+    printf(" \n");
     if (tokens[current_token].type == TOKEN_KEYWORD)
     {
         current_token++;
@@ -517,21 +517,17 @@ void factor()
 int main()
 {
     const char *filename = "input.c";
-    char *code = read_file(filename);
+    read_file(filename, &source);
 
     // Use the global tokens array
-    tokens = tokenize(code, &token_count);
+    tokens = tokenize(source.data, source.length, &token_count);
 
     print_tokens(tokens, token_count);
     parse();
 
     // Free allocated memory
-    for (int i = 0; i < token_count; i++)
-    {
-        free(tokens[i].value);
-    }
     free(tokens);
-    free(code);
+    source_close(&source);
 
     return 0;
 }
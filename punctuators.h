@@ -0,0 +1,172 @@
+#ifndef PUNCTUATORS_H
+#define PUNCTUATORS_H
+
+// Generated by tools/gen_punctuators.c; do not edit.
+
+#include <stddef.h>
+
+typedef enum
+{
+    CC_OTHER,
+    CC_BLANK,
+    CC_WORD,
+    CC_DIGIT,
+    CC_QUOTE,
+    CC_APOSTROPHE,
+    CC_HASH,
+    CC_PUNCT, // first of the punctuator characters' classes
+    CC_COUNT = 31
+} CharClass;
+
+typedef enum
+{
+    PUNCT_NONE,
+    PUNCT_LPAREN, // (
+    PUNCT_RPAREN, // )
+    PUNCT_LBRACE, // {
+    PUNCT_RBRACE, // }
+    PUNCT_LBRACKET, // [
+    PUNCT_RBRACKET, // ]
+    PUNCT_SEMICOLON, // ;
+    PUNCT_COMMA, // ,
+    PUNCT_COLON, // :
+    PUNCT_DOT, // .
+    PUNCT_QUESTION, // ?
+    PUNCT_ARROW, // ->
+    PUNCT_PLUS, // +
+    PUNCT_MINUS, // -
+    PUNCT_STAR, // *
+    PUNCT_SLASH, // /
+    PUNCT_PERCENT, // %
+    PUNCT_INCREMENT, // ++
+    PUNCT_DECREMENT, // --
+    PUNCT_EQUAL, // ==
+    PUNCT_NOT_EQUAL, // !=
+    PUNCT_LESS, // <
+    PUNCT_GREATER, // >
+    PUNCT_LESS_EQUAL, // <=
+    PUNCT_GREATER_EQUAL, // >=
+    PUNCT_AND, // &&
+    PUNCT_OR, // ||
+    PUNCT_NOT, // !
+    PUNCT_AMPERSAND, // &
+    PUNCT_PIPE, // |
+    PUNCT_CARET, // ^
+    PUNCT_TILDE, // ~
+    PUNCT_SHIFT_LEFT, // <<
+    PUNCT_SHIFT_RIGHT, // >>
+    PUNCT_ASSIGN, // =
+    PUNCT_ADD_ASSIGN, // +=
+    PUNCT_SUB_ASSIGN, // -=
+    PUNCT_MUL_ASSIGN, // *=
+    PUNCT_DIV_ASSIGN, // /=
+    PUNCT_MOD_ASSIGN, // %=
+    PUNCT_AND_ASSIGN, // &=
+    PUNCT_OR_ASSIGN, // |=
+    PUNCT_XOR_ASSIGN, // ^=
+    PUNCT_SHIFT_LEFT_ASSIGN, // <<=
+    PUNCT_SHIFT_RIGHT_ASSIGN, // >>=
+    PUNCT_COUNT
+} Punctuator;
+
+static const unsigned char char_class[256] = {
+    ['\n'] = CC_BLANK,
+    [' '] = CC_BLANK,
+    ['!'] = CC_PUNCT + 18,
+    ['"'] = CC_QUOTE,
+    ['#'] = CC_HASH,
+    ['%'] = CC_PUNCT + 16,
+    ['&'] = CC_PUNCT + 20,
+    ['\''] = CC_APOSTROPHE,
+    ['('] = CC_PUNCT + 0,
+    [')'] = CC_PUNCT + 1,
+    ['*'] = CC_PUNCT + 14,
+    ['+'] = CC_PUNCT + 13,
+    [','] = CC_PUNCT + 7,
+    ['-'] = CC_PUNCT + 11,
+    ['.'] = CC_PUNCT + 9,
+    ['/'] = CC_PUNCT + 15,
+    ['0' ... '9'] = CC_DIGIT,
+    [':'] = CC_PUNCT + 8,
+    [';'] = CC_PUNCT + 6,
+    ['<'] = CC_PUNCT + 19,
+    ['='] = CC_PUNCT + 17,
+    ['>'] = CC_PUNCT + 12,
+    ['?'] = CC_PUNCT + 10,
+    ['A' ... 'Z'] = CC_WORD,
+    ['['] = CC_PUNCT + 4,
+    [']'] = CC_PUNCT + 5,
+    ['^'] = CC_PUNCT + 22,
+    ['_'] = CC_WORD,
+    ['a' ... 'z'] = CC_WORD,
+    ['{'] = CC_PUNCT + 2,
+    ['|'] = CC_PUNCT + 21,
+    ['}'] = CC_PUNCT + 3,
+    ['~'] = CC_PUNCT + 23,
+};
+
+// punct_next[state][class]: the punctuator read so far extended by one
+// more character, or PUNCT_NONE when it cannot be.
+static const unsigned char punct_next[PUNCT_COUNT][CC_COUNT] = {
+    [PUNCT_NONE] = {[CC_PUNCT + 0] = PUNCT_LPAREN,
+        [CC_PUNCT + 1] = PUNCT_RPAREN,
+        [CC_PUNCT + 2] = PUNCT_LBRACE,
+        [CC_PUNCT + 3] = PUNCT_RBRACE,
+        [CC_PUNCT + 4] = PUNCT_LBRACKET,
+        [CC_PUNCT + 5] = PUNCT_RBRACKET,
+        [CC_PUNCT + 6] = PUNCT_SEMICOLON,
+        [CC_PUNCT + 7] = PUNCT_COMMA,
+        [CC_PUNCT + 8] = PUNCT_COLON,
+        [CC_PUNCT + 9] = PUNCT_DOT,
+        [CC_PUNCT + 10] = PUNCT_QUESTION,
+        [CC_PUNCT + 11] = PUNCT_MINUS,
+        [CC_PUNCT + 12] = PUNCT_GREATER,
+        [CC_PUNCT + 13] = PUNCT_PLUS,
+        [CC_PUNCT + 14] = PUNCT_STAR,
+        [CC_PUNCT + 15] = PUNCT_SLASH,
+        [CC_PUNCT + 16] = PUNCT_PERCENT,
+        [CC_PUNCT + 17] = PUNCT_ASSIGN,
+        [CC_PUNCT + 18] = PUNCT_NOT,
+        [CC_PUNCT + 19] = PUNCT_LESS,
+        [CC_PUNCT + 20] = PUNCT_AMPERSAND,
+        [CC_PUNCT + 21] = PUNCT_PIPE,
+        [CC_PUNCT + 22] = PUNCT_CARET,
+        [CC_PUNCT + 23] = PUNCT_TILDE},
+    [PUNCT_PLUS] = {[CC_PUNCT + 13] = PUNCT_INCREMENT,
+        [CC_PUNCT + 17] = PUNCT_ADD_ASSIGN},
+    [PUNCT_MINUS] = {[CC_PUNCT + 11] = PUNCT_DECREMENT,
+        [CC_PUNCT + 12] = PUNCT_ARROW,
+        [CC_PUNCT + 17] = PUNCT_SUB_ASSIGN},
+    [PUNCT_STAR] = {[CC_PUNCT + 17] = PUNCT_MUL_ASSIGN},
+    [PUNCT_SLASH] = {[CC_PUNCT + 17] = PUNCT_DIV_ASSIGN},
+    [PUNCT_PERCENT] = {[CC_PUNCT + 17] = PUNCT_MOD_ASSIGN},
+    [PUNCT_LESS] = {[CC_PUNCT + 17] = PUNCT_LESS_EQUAL,
+        [CC_PUNCT + 19] = PUNCT_SHIFT_LEFT},
+    [PUNCT_GREATER] = {[CC_PUNCT + 12] = PUNCT_SHIFT_RIGHT,
+        [CC_PUNCT + 17] = PUNCT_GREATER_EQUAL},
+    [PUNCT_NOT] = {[CC_PUNCT + 17] = PUNCT_NOT_EQUAL},
+    [PUNCT_AMPERSAND] = {[CC_PUNCT + 17] = PUNCT_AND_ASSIGN,
+        [CC_PUNCT + 20] = PUNCT_AND},
+    [PUNCT_PIPE] = {[CC_PUNCT + 17] = PUNCT_OR_ASSIGN,
+        [CC_PUNCT + 21] = PUNCT_OR},
+    [PUNCT_CARET] = {[CC_PUNCT + 17] = PUNCT_XOR_ASSIGN},
+    [PUNCT_SHIFT_LEFT] = {[CC_PUNCT + 17] = PUNCT_SHIFT_LEFT_ASSIGN},
+    [PUNCT_SHIFT_RIGHT] = {[CC_PUNCT + 17] = PUNCT_SHIFT_RIGHT_ASSIGN},
+    [PUNCT_ASSIGN] = {[CC_PUNCT + 17] = PUNCT_EQUAL},
+};
+
+// The longest punctuator at p, or PUNCT_NONE if none starts there; *length
+// is its length. One table lookup per byte.
+static inline Punctuator punct_munch(const char *p, const char *end, size_t *length)
+{
+    const char *start = p;
+    unsigned state = PUNCT_NONE;
+    while (p < end && punct_next[state][char_class[(unsigned char)*p]])
+    {
+        state = punct_next[state][char_class[(unsigned char)*p++]];
+    }
+    *length = p - start;
+    return state;
+}
+
+#endif
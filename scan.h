@@ -0,0 +1,474 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Bulk byte scans for the lexer: the end of an identifier or digit run, the
+// next occurrence of a byte, the "*/" closing a block comment, and the end of
+// a run of spaces and newlines; and for line_index.h, counting a byte and
+// listing where it occurs. Each kernel classifies 16 (SSE2) or 32 (AVX2)
+// bytes per step and finishes the last partial block one byte at a time, so
+// no load reaches past end. The widest level the CPU supports is picked on
+// first use; scan_set_level() lowers it, e.g. to compare kernels. Building
+// with -DC2JS_NO_SIMD, or for a target other than x86, leaves only the
+// scalar loops, which every level must agree with byte for byte.
+
+typedef enum
+{
+    SCAN_SCALAR,
+    SCAN_SSE2,
+    SCAN_AVX2
+} ScanLevel;
+
+static const char *scan_level_names[] = {"scalar", "sse2", "avx2"};
+
+#if !defined(C2JS_NO_SIMD) && (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+static atomic_int scanLevel = -1;
+
+static ScanLevel scan_supported_level()
+{
+#ifdef SCAN_X86
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return SCAN_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2"))
+    {
+        return SCAN_SSE2;
+    }
+#endif
+    return SCAN_SCALAR;
+}
+
+static ScanLevel scan_level()
+{
+    int level = atomic_load_explicit(&scanLevel, memory_order_relaxed);
+    if (level < 0)
+    {
+        level = scan_supported_level();
+        atomic_store_explicit(&scanLevel, level, memory_order_relaxed);
+    }
+    return level;
+}
+
+// Uses at most the given level; returns the level actually used.
+static ScanLevel scan_set_level(ScanLevel level)
+{
+    ScanLevel supported = scan_supported_level();
+    level = level < supported ? level : supported;
+    atomic_store_explicit(&scanLevel, level, memory_order_relaxed);
+    return level;
+}
+
+static inline int scan_is_word(unsigned char c)
+{
+    return (c | 0x20) - 'a' < 26u || c - '0' < 10u || c == '_';
+}
+
+static const char *scan_word_end_scalar(const char *p, const char *end)
+{
+    while (p < end && scan_is_word(*p))
+    {
+        p++;
+    }
+    return p;
+}
+
+static const char *scan_digits_end_scalar(const char *p, const char *end)
+{
+    while (p < end && (unsigned char)*p - '0' < 10u)
+    {
+        p++;
+    }
+    return p;
+}
+
+static const char *scan_find_scalar(const char *p, const char *end, char c)
+{
+    while (p < end && *p != c)
+    {
+        p++;
+    }
+    return p;
+}
+
+static const char *scan_comment_end_scalar(const char *p, const char *end)
+{
+    while (p + 1 < end && !(p[0] == '*' && p[1] == '/'))
+    {
+        p++;
+    }
+    return p + 1 < end ? p : end;
+}
+
+static const char *scan_blank_end_scalar(const char *p, const char *end)
+{
+    while (p < end && (*p == ' ' || *p == '\n'))
+    {
+        p++;
+    }
+    return p;
+}
+
+static size_t scan_count_scalar(const char *p, const char *end, char c)
+{
+    size_t count = 0;
+    for (; p < end; p++)
+    {
+        count += *p == c;
+    }
+    return count;
+}
+
+static uint32_t *scan_offsets_after_scalar(const char *p, const char *end, char c, const char *base, uint32_t *out)
+{
+    for (; p < end; p++)
+    {
+        if (*p == c)
+        {
+            *out++ = (uint32_t)(p - base) + 1;
+        }
+    }
+    return out;
+}
+
+#ifdef SCAN_X86
+
+// Bytes where lo <= byte < lo + count, as unsigned values. SSE2 compares are
+// signed, so both sides are shifted down by 128 first.
+#define SCAN_RANGE128(v, lo, count) \
+    _mm_cmplt_epi8(_mm_sub_epi8((v), _mm_set1_epi8((char)((lo) + 128))), _mm_set1_epi8((char)(-128 + (count))))
+#define SCAN_RANGE256(v, lo, count) \
+    _mm256_cmpgt_epi8(_mm256_set1_epi8((char)(-128 + (count))), _mm256_sub_epi8((v), _mm256_set1_epi8((char)((lo) + 128))))
+
+__attribute__((target("sse2"))) static const char *scan_word_end_sse2(const char *p, const char *end)
+{
+    for (; end - p >= 16; p += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        __m128i word = _mm_or_si128(SCAN_RANGE128(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 26), SCAN_RANGE128(v, '0', 10));
+        unsigned other = ~_mm_movemask_epi8(_mm_or_si128(word, _mm_cmpeq_epi8(v, _mm_set1_epi8('_')))) & 0xFFFF;
+        if (other)
+        {
+            return p + __builtin_ctz(other);
+        }
+    }
+    return scan_word_end_scalar(p, end);
+}
+
+__attribute__((target("avx2"))) static const char *scan_word_end_avx2(const char *p, const char *end)
+{
+    for (; end - p >= 32; p += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)p);
+        __m256i word = _mm256_or_si256(SCAN_RANGE256(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 26), SCAN_RANGE256(v, '0', 10));
+        unsigned other = ~(unsigned)_mm256_movemask_epi8(_mm256_or_si256(word, _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_'))));
+        if (other)
+        {
+            return p + __builtin_ctz(other);
+        }
+    }
+    return scan_word_end_sse2(p, end);
+}
+
+__attribute__((target("sse2"))) static const char *scan_digits_end_sse2(const char *p, const char *end)
+{
+    for (; end - p >= 16; p += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        unsigned other = ~_mm_movemask_epi8(SCAN_RANGE128(v, '0', 10)) & 0xFFFF;
+        if (other)
+        {
+            return p + __builtin_ctz(other);
+        }
+    }
+    return scan_digits_end_scalar(p, end);
+}
+
+__attribute__((target("avx2"))) static const char *scan_digits_end_avx2(const char *p, const char *end)
+{
+    for (; end - p >= 32; p += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)p);
+        unsigned other = ~(unsigned)_mm256_movemask_epi8(SCAN_RANGE256(v, '0', 10));
+        if (other)
+        {
+            return p + __builtin_ctz(other);
+        }
+    }
+    return scan_digits_end_sse2(p, end);
+}
+
+__attribute__((target("sse2"))) static const char *scan_find_sse2(const char *p, const char *end, char c)
+{
+    __m128i target = _mm_set1_epi8(c);
+    for (; end - p >= 16; p += 16)
+    {
+        unsigned found = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)p), target));
+        if (found)
+        {
+            return p + __builtin_ctz(found);
+        }
+    }
+    return scan_find_scalar(p, end, c);
+}
+
+__attribute__((target("avx2"))) static const char *scan_find_avx2(const char *p, const char *end, char c)
+{
+    __m256i target = _mm256_set1_epi8(c);
+    for (; end - p >= 32; p += 32)
+    {
+        unsigned found = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)p), target));
+        if (found)
+        {
+            return p + __builtin_ctz(found);
+        }
+    }
+    return scan_find_sse2(p, end, c);
+}
+
+// A '*' at i closes the comment when the block loaded one byte later has a
+// '/' at i, so no mask has to carry across blocks.
+__attribute__((target("sse2"))) static const char *scan_comment_end_sse2(const char *p, const char *end)
+{
+    for (; end - p >= 17; p += 16)
+    {
+        unsigned star = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)p), _mm_set1_epi8('*')));
+        unsigned slash = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + 1)), _mm_set1_epi8('/')));
+        if (star & slash)
+        {
+            return p + __builtin_ctz(star & slash);
+        }
+    }
+    return scan_comment_end_scalar(p, end);
+}
+
+__attribute__((target("avx2"))) static const char *scan_comment_end_avx2(const char *p, const char *end)
+{
+    for (; end - p >= 33; p += 32)
+    {
+        unsigned star = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)p), _mm256_set1_epi8('*')));
+        unsigned slash = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p + 1)), _mm256_set1_epi8('/')));
+        if (star & slash)
+        {
+            return p + __builtin_ctz(star & slash);
+        }
+    }
+    return scan_comment_end_sse2(p, end);
+}
+
+__attribute__((target("sse2"))) static const char *scan_blank_end_sse2(const char *p, const char *end)
+{
+    for (; end - p >= 16; p += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        __m128i blank = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+        unsigned other = ~_mm_movemask_epi8(blank) & 0xFFFF;
+        if (other)
+        {
+            return p + __builtin_ctz(other);
+        }
+    }
+    return scan_blank_end_scalar(p, end);
+}
+
+__attribute__((target("avx2"))) static const char *scan_blank_end_avx2(const char *p, const char *end)
+{
+    for (; end - p >= 32; p += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)p);
+        __m256i blank = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')));
+        unsigned other = ~(unsigned)_mm256_movemask_epi8(blank);
+        if (other)
+        {
+            return p + __builtin_ctz(other);
+        }
+    }
+    return scan_blank_end_sse2(p, end);
+}
+
+// A popcount of the match mask per block.
+__attribute__((target("sse2"))) static size_t scan_count_sse2(const char *p, const char *end, char c)
+{
+    size_t count = 0;
+    for (; end - p >= 16; p += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        count += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c))));
+    }
+    return count + scan_count_scalar(p, end, c);
+}
+
+__attribute__((target("avx2,popcnt"))) static size_t scan_count_avx2(const char *p, const char *end, char c)
+{
+    size_t count = 0;
+    for (; end - p >= 32; p += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)p);
+        count += __builtin_popcount(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(c))));
+    }
+    return count + scan_count_sse2(p, end, c);
+}
+
+// Each set bit of the match mask is taken off with ctz, so a block without
+// the byte costs one compare and one branch.
+__attribute__((target("sse2"))) static uint32_t *scan_offsets_after_sse2(const char *p, const char *end, char c, const char *base, uint32_t *out)
+{
+    for (; end - p >= 16; p += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)p);
+        unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(c)));
+        uint32_t offset = (uint32_t)(p - base) + 1;
+        for (; mask; mask &= mask - 1)
+        {
+            *out++ = offset + __builtin_ctz(mask);
+        }
+    }
+    return scan_offsets_after_scalar(p, end, c, base, out);
+}
+
+__attribute__((target("avx2"))) static uint32_t *scan_offsets_after_avx2(const char *p, const char *end, char c, const char *base, uint32_t *out)
+{
+    for (; end - p >= 32; p += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i *)p);
+        unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(c)));
+        uint32_t offset = (uint32_t)(p - base) + 1;
+        for (; mask; mask &= mask - 1)
+        {
+            *out++ = offset + __builtin_ctz(mask);
+        }
+    }
+    return scan_offsets_after_sse2(p, end, c, base, out);
+}
+
+#endif
+
+// First byte at or after p that cannot continue an identifier, or end.
+static const char *scan_word_end(const char *p, const char *end)
+{
+#ifdef SCAN_X86
+    switch (scan_level())
+    {
+    case SCAN_AVX2:
+        return scan_word_end_avx2(p, end);
+    case SCAN_SSE2:
+        return scan_word_end_sse2(p, end);
+    default:
+        break;
+    }
+#endif
+    return scan_word_end_scalar(p, end);
+}
+
+// First byte at or after p that is not a decimal digit, or end.
+static const char *scan_digits_end(const char *p, const char *end)
+{
+#ifdef SCAN_X86
+    switch (scan_level())
+    {
+    case SCAN_AVX2:
+        return scan_digits_end_avx2(p, end);
+    case SCAN_SSE2:
+        return scan_digits_end_sse2(p, end);
+    default:
+        break;
+    }
+#endif
+    return scan_digits_end_scalar(p, end);
+}
+
+// First occurrence of c at or after p, or end.
+static const char *scan_find(const char *p, const char *end, char c)
+{
+#ifdef SCAN_X86
+    switch (scan_level())
+    {
+    case SCAN_AVX2:
+        return scan_find_avx2(p, end, c);
+    case SCAN_SSE2:
+        return scan_find_sse2(p, end, c);
+    default:
+        break;
+    }
+#endif
+    return scan_find_scalar(p, end, c);
+}
+
+// The '*' of the first "*/" at or after p, or end if the comment is unclosed.
+static const char *scan_comment_end(const char *p, const char *end)
+{
+#ifdef SCAN_X86
+    switch (scan_level())
+    {
+    case SCAN_AVX2:
+        return scan_comment_end_avx2(p, end);
+    case SCAN_SSE2:
+        return scan_comment_end_sse2(p, end);
+    default:
+        break;
+    }
+#endif
+    return scan_comment_end_scalar(p, end);
+}
+
+// First byte at or after p that is neither ' ' nor '\n', or end.
+static const char *scan_blank_end(const char *p, const char *end)
+{
+#ifdef SCAN_X86
+    switch (scan_level())
+    {
+    case SCAN_AVX2:
+        return scan_blank_end_avx2(p, end);
+    case SCAN_SSE2:
+        return scan_blank_end_sse2(p, end);
+    default:
+        break;
+    }
+#endif
+    return scan_blank_end_scalar(p, end);
+}
+
+// How many times c occurs in [p, end).
+static size_t scan_count(const char *p, const char *end, char c)
+{
+#ifdef SCAN_X86
+    switch (scan_level())
+    {
+    case SCAN_AVX2:
+        return scan_count_avx2(p, end, c);
+    case SCAN_SSE2:
+        return scan_count_sse2(p, end, c);
+    default:
+        break;
+    }
+#endif
+    return scan_count_scalar(p, end, c);
+}
+
+// Writes, in order, the offset from base of the byte just after each c in
+// [p, end), and returns one past the last offset written. out must have room
+// for scan_count(p, end, c) of them.
+static uint32_t *scan_offsets_after(const char *p, const char *end, char c, const char *base, uint32_t *out)
+{
+#ifdef SCAN_X86
+    switch (scan_level())
+    {
+    case SCAN_AVX2:
+        return scan_offsets_after_avx2(p, end, c, base, out);
+    case SCAN_SSE2:
+        return scan_offsets_after_sse2(p, end, c, base, out);
+    default:
+        break;
+    }
+#endif
+    return scan_offsets_after_scalar(p, end, c, base, out);
+}
+
+#endif
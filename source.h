@@ -0,0 +1,124 @@
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read-only view of an input file. Regular files are mapped, so the lexer
+// reads the page cache directly and no copy of the source is ever made.
+// Pipes, terminals and anything else mmap() refuses are read into a heap
+// buffer instead. The data is not NUL-terminated.
+
+typedef struct
+{
+    const char *data;
+    size_t length;
+    bool mapped; // data is an mmap() of the file, not a malloc() buffer
+} SourceFile;
+
+static bool source_read_stream(int fd, SourceFile *source)
+{
+    size_t capacity = 64 * 1024;
+    char *buffer = malloc(capacity);
+    size_t length = 0;
+    for (;;)
+    {
+        if (!buffer)
+        {
+            return false;
+        }
+        if (length == capacity)
+        {
+            capacity *= 2;
+            char *grown = realloc(buffer, capacity);
+            if (!grown)
+            {
+                free(buffer);
+                return false;
+            }
+            buffer = grown;
+        }
+        ssize_t count = read(fd, buffer + length, capacity - length);
+        if (count < 0)
+        {
+            free(buffer);
+            return false;
+        }
+        if (count == 0)
+        {
+            break;
+        }
+        length += count;
+    }
+    source->data = buffer;
+    source->length = length;
+    source->mapped = false;
+    return true;
+}
+
+// Opens filename ("-" for standard input), or returns false with errno set.
+static bool source_open(const char *filename, SourceFile *source)
+{
+    bool isStdin = filename[0] == '-' && filename[1] == '\0';
+    int fd = isStdin ? STDIN_FILENO : open(filename, O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat st;
+    bool opened = false;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+    {
+        void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED)
+        {
+            // The lexer makes one front-to-back pass.
+            posix_madvise(data, st.st_size, POSIX_MADV_SEQUENTIAL);
+            source->data = data;
+            source->length = st.st_size;
+            source->mapped = true;
+            opened = true;
+        }
+    }
+    if (!opened)
+    {
+        opened = source_read_stream(fd, source);
+    }
+
+    if (!isStdin)
+    {
+        close(fd);
+    }
+    return opened;
+}
+
+static void source_close(SourceFile *source)
+{
+    if (source->mapped)
+    {
+        munmap((void *)source->data, source->length);
+    }
+    else
+    {
+        free((void *)source->data);
+    }
+    source->data = NULL;
+    source->length = 0;
+}
+
+static void read_file(const char *filename, SourceFile *source)
+{
+    if (!source_open(filename, source))
+    {
+        perror("Failed to open file");
+        exit(EXIT_FAILURE);
+    }
+}
+
+#endif
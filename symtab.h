@@ -0,0 +1,160 @@
+#ifndef SYMTAB_H
+#define SYMTAB_H
+
+#include <stdint.h>
+#include <string.h>
+#include "arena.h"
+
+// Block-scoped symbol table keyed by intern ID. An open-addressing table
+// holds the innermost visible declaration of each name, so lookups are O(1)
+// whatever the number of locals. Declaring a name that is already visible
+// from an outer scope pushes the outer binding onto an undo log, and leaving
+// a scope replays the log back to the scope's mark, which restores shadowed
+// names and hides the scope's own declarations in O(declarations).
+// Keys are never removed; a name with no visible declaration has depth -1.
+// All storage comes from the arena; call symtab_init() again after a reset.
+
+typedef struct
+{
+    uint32_t name; // intern ID + 1, or 0 for an empty slot
+    uint32_t type; // intern ID of the declared type
+    int depth;     // scope depth of the visible declaration, -1 for none
+} SymbolSlot;
+
+typedef struct
+{
+    uint32_t name;
+    uint32_t type;
+    int depth;
+} SymbolUndo;
+
+typedef struct
+{
+    SymbolSlot *slots;
+    uint32_t slotCount;
+    uint32_t used;
+    SymbolUndo *undo;
+    uint32_t undoCount;
+    uint32_t undoCapacity;
+    uint32_t *scopeMarks; // undoCount at each scope entry
+    int depth;
+    int scopeCapacity;
+    Arena *arena;
+} SymbolTable;
+
+static uint32_t symtab_hash(uint32_t name)
+{
+    // Intern IDs are dense; Fibonacci hashing spreads runs of them.
+    return name * 2654435769u;
+}
+
+static void *symtab_regrow(Arena *arena, const void *old, size_t oldSize, size_t newSize)
+{
+    void *memory = arena_alloc(arena, newSize);
+    if (old)
+    {
+        memcpy(memory, old, oldSize);
+    }
+    return memory;
+}
+
+static SymbolSlot *symtab_slot(SymbolSlot *slots, uint32_t slotCount, uint32_t name)
+{
+    uint32_t slot = symtab_hash(name) & (slotCount - 1);
+    while (slots[slot].name && slots[slot].name != name + 1)
+    {
+        slot = (slot + 1) & (slotCount - 1);
+    }
+    return &slots[slot];
+}
+
+static void symtab_grow_slots(SymbolTable *table)
+{
+    uint32_t slotCount = table->slotCount ? table->slotCount * 2 : 1024;
+    SymbolSlot *slots = arena_alloc(table->arena, sizeof(SymbolSlot) * slotCount);
+    memset(slots, 0, sizeof(SymbolSlot) * slotCount);
+    for (uint32_t i = 0; i < table->slotCount; i++)
+    {
+        if (table->slots[i].name)
+        {
+            *symtab_slot(slots, slotCount, table->slots[i].name - 1) = table->slots[i];
+        }
+    }
+    table->slots = slots;
+    table->slotCount = slotCount;
+}
+
+static void symtab_init(SymbolTable *table, Arena *arena)
+{
+    memset(table, 0, sizeof(SymbolTable));
+    table->arena = arena;
+    symtab_grow_slots(table);
+}
+
+static void symtab_enter_scope(SymbolTable *table)
+{
+    if (table->depth == table->scopeCapacity)
+    {
+        int capacity = table->scopeCapacity ? table->scopeCapacity * 2 : 64;
+        table->scopeMarks = symtab_regrow(table->arena, table->scopeMarks, sizeof(uint32_t) * table->scopeCapacity, sizeof(uint32_t) * capacity);
+        table->scopeCapacity = capacity;
+    }
+    table->scopeMarks[table->depth++] = table->undoCount;
+}
+
+// Leaving the outermost scope is ignored, so stray closing braces are harmless.
+static void symtab_leave_scope(SymbolTable *table)
+{
+    if (table->depth == 0)
+    {
+        return;
+    }
+    uint32_t mark = table->scopeMarks[--table->depth];
+    while (table->undoCount > mark)
+    {
+        SymbolUndo *undo = &table->undo[--table->undoCount];
+        SymbolSlot *slot = symtab_slot(table->slots, table->slotCount, undo->name);
+        slot->type = undo->type;
+        slot->depth = undo->depth;
+    }
+}
+
+static void symtab_declare(SymbolTable *table, uint32_t name, uint32_t type)
+{
+    SymbolSlot *slot = symtab_slot(table->slots, table->slotCount, name);
+    if (!slot->name)
+    {
+        if ((table->used + 1) * 2 > table->slotCount)
+        {
+            symtab_grow_slots(table);
+            slot = symtab_slot(table->slots, table->slotCount, name);
+        }
+        slot->name = name + 1;
+        slot->depth = -1;
+        table->used++;
+    }
+
+    // Redeclaring in the same scope just updates the binding; otherwise the
+    // outer one is saved for symtab_leave_scope().
+    if (slot->depth != table->depth && table->depth > 0)
+    {
+        if (table->undoCount == table->undoCapacity)
+        {
+            uint32_t capacity = table->undoCapacity ? table->undoCapacity * 2 : 256;
+            table->undo = symtab_regrow(table->arena, table->undo, sizeof(SymbolUndo) * table->undoCapacity, sizeof(SymbolUndo) * capacity);
+            table->undoCapacity = capacity;
+        }
+        table->undo[table->undoCount++] = (SymbolUndo){name, slot->type, slot->depth};
+    }
+    slot->type = type;
+    slot->depth = table->depth;
+}
+
+// Returns the innermost visible declaration of name, or NULL.
+static const SymbolSlot *symtab_lookup(const SymbolTable *table, uint32_t name)
+{
+    const SymbolSlot *slot = symtab_slot(table->slots, table->slotCount, name);
+    return slot->name && slot->depth >= 0 ? slot : NULL;
+}
+
+#endif
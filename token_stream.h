@@ -0,0 +1,82 @@
+#ifndef TOKEN_STREAM_H
+#define TOKEN_STREAM_H
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// The tokens of lexer.h as parallel arrays: token i is types[i], a slice of
+// lengths[i] bytes at offsets[i] in the source, with intern ID ids[i]. That
+// is 13 bytes a token, and a scan over the types alone, which is most of
+// what the parser does, touches one byte per token. Lines and columns are
+// not stored; line_index.h finds them from the offsets.
+
+typedef struct
+{
+    uint8_t *types; // TokenType
+    uint32_t *offsets;
+    uint32_t *lengths;
+    uint32_t *ids;
+    int count;
+    int capacity;
+} TokenStream;
+
+static void *token_stream_realloc(void *data, size_t size)
+{
+    void *grown = realloc(data, size);
+    if (!grown)
+    {
+        perror("Failed to grow tokens");
+        exit(EXIT_FAILURE);
+    }
+    return grown;
+}
+
+static void token_stream_grow(TokenStream *stream, int capacity)
+{
+    stream->types = token_stream_realloc(stream->types, sizeof(uint8_t) * capacity);
+    stream->offsets = token_stream_realloc(stream->offsets, sizeof(uint32_t) * capacity);
+    stream->lengths = token_stream_realloc(stream->lengths, sizeof(uint32_t) * capacity);
+    stream->ids = token_stream_realloc(stream->ids, sizeof(uint32_t) * capacity);
+    stream->capacity = capacity;
+}
+
+// Empties the stream and makes room for roughly one token per four bytes of
+// source, so most inputs never regrow. Existing arrays are kept when they
+// are big enough, so a reused stream stops allocating after its largest
+// input.
+static void token_stream_reset(TokenStream *stream, size_t sourceLength)
+{
+    int wanted = (int)(sourceLength / 4) + 64;
+    stream->count = 0;
+    if (stream->capacity < wanted)
+    {
+        token_stream_grow(stream, wanted);
+    }
+}
+
+static void token_stream_free(TokenStream *stream)
+{
+    free(stream->types);
+    free(stream->offsets);
+    free(stream->lengths);
+    free(stream->ids);
+    *stream = (TokenStream){0};
+}
+
+static inline void token_stream_push(TokenStream *stream, uint8_t type, uint32_t offset, uint32_t length, uint32_t id)
+{
+    if (stream->count == stream->capacity)
+    {
+        // Never wraps: inputs are limited to fewer than INT_MAX tokens.
+        token_stream_grow(stream, stream->capacity == 0 ? 64 : stream->capacity > INT_MAX / 2 ? INT_MAX : stream->capacity * 2);
+    }
+    int i = stream->count++;
+    stream->types[i] = type;
+    stream->offsets[i] = offset;
+    stream->lengths[i] = length;
+    stream->ids[i] = id;
+}
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef TOKEN_VECTOR_H
+#define TOKEN_VECTOR_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Growable token array of project.c (lexer.h stores its tokens in the
+// parallel arrays of token_stream.h).
+// The including file must define its Token type before including this header.
+
+typedef struct
+{
+    Token *data;
+    int count;
+    int capacity;
+} TokenVector;
+
+// Empties the vector and makes room for roughly one token per four bytes of
+// source, so most inputs never regrow. An existing allocation is kept when it
+// is big enough, so a reused vector stops allocating after its largest input.
+static void token_vector_reset(TokenVector *vector, size_t sourceLength)
+{
+    int wanted = (int)(sourceLength / 4) + 64;
+    vector->count = 0;
+    if (vector->capacity < wanted)
+    {
+        free(vector->data);
+        vector->capacity = wanted;
+        vector->data = malloc(sizeof(Token) * vector->capacity);
+        if (!vector->data)
+        {
+            perror("Failed to allocate tokens");
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+static void token_vector_init(TokenVector *vector, size_t sourceLength)
+{
+    vector->data = NULL;
+    vector->capacity = 0;
+    token_vector_reset(vector, sourceLength);
+}
+
+static void token_vector_push(TokenVector *vector, Token token)
+{
+    if (vector->count == vector->capacity)
+    {
+        vector->capacity *= 2;
+        Token *grown = realloc(vector->data, sizeof(Token) * vector->capacity);
+        if (!grown)
+        {
+            perror("Failed to grow tokens");
+            exit(EXIT_FAILURE);
+        }
+        vector->data = grown;
+    }
+    vector->data[vector->count++] = token;
+}
+
+#endif
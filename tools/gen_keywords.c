@@ -0,0 +1,145 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+// Generates keywords.h: a perfect hash over the reserved words of lexer.h,
+// keyed on identifier length and its first and last characters.
+//
+//     gcc tools/gen_keywords.c -o gen_keywords && ./gen_keywords > keywords.h
+//
+// Words are listed in classification priority order; a word that appears in
+// more than one group keeps the first group ("do" is a keyword, not a loop).
+
+#define TABLE_SIZE 128
+
+typedef struct
+{
+    const char *type;
+    const char *words[12];
+} Group;
+
+static const Group groups[] = {
+    {"KEYWORDS", {"auto", "break", "case", "const", "continue", "default", "do", "enum", "goto", "return"}},
+    {"DATA_TYPES", {"int", "char", "float", "double", "void", "long", "short", "unsigned", "signed"}},
+    {"LOOP", {"for", "while", "do"}},
+    {"CONDITIONAL", {"if", "else", "switch", "case", "default"}},
+    {"FUNCTION", {"strcmp", "strcpy"}},
+    {"INPUTS", {"scanf", "getchar", "getch", "getche"}},
+    {"OUTPUTS", {"printf", "putchar", "puts"}},
+};
+
+typedef struct
+{
+    const char *word;
+    const char *type;
+} Entry;
+
+static Entry entries[TABLE_SIZE];
+static int entryCount = 0;
+
+static unsigned slot_of(const char *word, unsigned a, unsigned b)
+{
+    size_t length = strlen(word);
+    return (length * a + (unsigned char)word[0] * b + (unsigned char)word[length - 1]) & (TABLE_SIZE - 1);
+}
+
+static int find_multipliers(unsigned *a, unsigned *b)
+{
+    for (*a = 1; *a < 256; (*a)++)
+    {
+        for (*b = 1; *b < 256; (*b)++)
+        {
+            unsigned char used[TABLE_SIZE] = {0};
+            int i = 0;
+            for (; i < entryCount; i++)
+            {
+                unsigned slot = slot_of(entries[i].word, *a, *b);
+                if (used[slot])
+                {
+                    break;
+                }
+                used[slot] = 1;
+            }
+            if (i == entryCount)
+            {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static void print_id(const char *word)
+{
+    printf("KW_");
+    for (const char *c = word; *c; c++)
+    {
+        putchar(toupper((unsigned char)*c));
+    }
+}
+
+int main()
+{
+    for (size_t g = 0; g < sizeof(groups) / sizeof(groups[0]); g++)
+    {
+        for (int w = 0; groups[g].words[w]; w++)
+        {
+            int seen = 0;
+            for (int i = 0; i < entryCount; i++)
+            {
+                seen |= strcmp(entries[i].word, groups[g].words[w]) == 0;
+            }
+            if (!seen)
+            {
+                entries[entryCount++] = (Entry){groups[g].words[w], groups[g].type};
+            }
+        }
+    }
+
+    unsigned a, b;
+    if (!find_multipliers(&a, &b))
+    {
+        fprintf(stderr, "No perfect hash found; grow TABLE_SIZE\n");
+        return 1;
+    }
+    unsigned char slotOwner[TABLE_SIZE] = {0};
+    for (int i = 0; i < entryCount; i++)
+    {
+        slotOwner[slot_of(entries[i].word, a, b)] = i + 1;
+    }
+
+    printf("#ifndef KEYWORDS_H\n#define KEYWORDS_H\n\n");
+    printf("// Generated by tools/gen_keywords.c; do not edit.\n");
+    printf("// Include after the TokenType enum.\n\n");
+
+    printf("typedef enum\n{\n    KW_NONE,\n");
+    for (int i = 0; i < entryCount; i++)
+    {
+        printf("    ");
+        print_id(entries[i].word);
+        printf(",\n");
+    }
+    printf("    KW_COUNT\n} KeywordId;\n\n");
+
+    printf("typedef struct\n{\n    unsigned char length;\n    char text[9];\n    TokenType type;\n    KeywordId id;\n} KeywordEntry;\n\n");
+
+    printf("static const KeywordEntry keyword_table[%d] = {\n", TABLE_SIZE);
+    for (int slot = 0; slot < TABLE_SIZE; slot++)
+    {
+        if (!slotOwner[slot])
+        {
+            continue;
+        }
+        const Entry *entry = &entries[slotOwner[slot] - 1];
+        printf("    [%d] = {%zu, \"%s\", %s, ", slot, strlen(entry->word), entry->word, entry->type);
+        print_id(entry->word);
+        printf("},\n");
+    }
+    printf("};\n\n");
+
+    printf("static inline unsigned keyword_slot(const char *text, size_t length)\n{\n");
+    printf("    return (length * %uu + (unsigned char)text[0] * %uu + (unsigned char)text[length - 1]) & %d;\n", a, b, TABLE_SIZE - 1);
+    printf("}\n\n#endif\n");
+    return 0;
+}
@@ -0,0 +1,208 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+// Generates punctuators.h: a 256-entry character class table for the lexer's
+// dispatch, and a DFA over those classes that recognises C punctuators with
+// maximal munch.
+//
+//     gcc tools/gen_punctuators.c -o gen_punctuators && ./gen_punctuators > punctuators.h
+//
+// Every prefix of a listed punctuator must itself be listed (so "..." is
+// not), which makes the DFA a trie whose states are the punctuators: the
+// state reached when no transition applies is the punctuator recognised.
+
+typedef struct
+{
+    const char *text;
+    const char *name;
+} Punctuator;
+
+static const Punctuator punctuators[] = {
+    {"(", "LPAREN"},       {")", "RPAREN"},        {"{", "LBRACE"},        {"}", "RBRACE"},
+    {"[", "LBRACKET"},     {"]", "RBRACKET"},      {";", "SEMICOLON"},     {",", "COMMA"},
+    {":", "COLON"},        {".", "DOT"},           {"?", "QUESTION"},      {"->", "ARROW"},
+    {"+", "PLUS"},         {"-", "MINUS"},         {"*", "STAR"},          {"/", "SLASH"},
+    {"%", "PERCENT"},      {"++", "INCREMENT"},    {"--", "DECREMENT"},    {"==", "EQUAL"},
+    {"!=", "NOT_EQUAL"},   {"<", "LESS"},          {">", "GREATER"},       {"<=", "LESS_EQUAL"},
+    {">=", "GREATER_EQUAL"}, {"&&", "AND"},        {"||", "OR"},           {"!", "NOT"},
+    {"&", "AMPERSAND"},    {"|", "PIPE"},          {"^", "CARET"},         {"~", "TILDE"},
+    {"<<", "SHIFT_LEFT"},  {">>", "SHIFT_RIGHT"},  {"=", "ASSIGN"},        {"+=", "ADD_ASSIGN"},
+    {"-=", "SUB_ASSIGN"},  {"*=", "MUL_ASSIGN"},   {"/=", "DIV_ASSIGN"},   {"%=", "MOD_ASSIGN"},
+    {"&=", "AND_ASSIGN"},  {"|=", "OR_ASSIGN"},    {"^=", "XOR_ASSIGN"},   {"<<=", "SHIFT_LEFT_ASSIGN"},
+    {">>=", "SHIFT_RIGHT_ASSIGN"},
+};
+
+#define PUNCTUATOR_COUNT (int)(sizeof(punctuators) / sizeof(punctuators[0]))
+
+// Classes before CC_PUNCT drive tokenize()'s dispatch; each punctuator
+// character gets a class of its own from CC_PUNCT on.
+static const char *fixed_classes[] = {"CC_OTHER", "CC_BLANK", "CC_WORD", "CC_DIGIT", "CC_QUOTE", "CC_APOSTROPHE", "CC_HASH"};
+#define FIXED_CLASS_COUNT (int)(sizeof(fixed_classes) / sizeof(fixed_classes[0]))
+
+static int classOf[256];
+static int classCount = FIXED_CLASS_COUNT;
+
+static void print_char(int c)
+{
+    if (c == '\n')
+    {
+        printf("'\\n'");
+    }
+    else if (c == '\'' || c == '\\')
+    {
+        printf("'\\%c'", c);
+    }
+    else
+    {
+        printf("'%c'", c);
+    }
+}
+
+static void print_class(int class)
+{
+    if (class < FIXED_CLASS_COUNT)
+    {
+        printf("%s", fixed_classes[class]);
+    }
+    else
+    {
+        printf("CC_PUNCT + %d", class - FIXED_CLASS_COUNT);
+    }
+}
+
+static int find_punctuator(const char *text, size_t length)
+{
+    for (int i = 0; i < PUNCTUATOR_COUNT; i++)
+    {
+        if (strlen(punctuators[i].text) == length && memcmp(punctuators[i].text, text, length) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int main()
+{
+    for (int c = 0; c < 256; c++)
+    {
+        classOf[c] = c == ' ' || c == '\n' ? 1 : isalpha(c) || c == '_' ? 2 : isdigit(c) ? 3 : c == '"' ? 4 : c == '\'' ? 5 : c == '#' ? 6 : 0;
+    }
+    for (int i = 0; i < PUNCTUATOR_COUNT; i++)
+    {
+        for (const char *p = punctuators[i].text; *p; p++)
+        {
+            if (classOf[(unsigned char)*p] == 0)
+            {
+                classOf[(unsigned char)*p] = classCount++;
+            }
+        }
+    }
+
+    // State 0 is the start; state i + 1 has just read punctuator i.
+    static int next[PUNCTUATOR_COUNT + 1][256];
+    for (int i = 0; i < PUNCTUATOR_COUNT; i++)
+    {
+        const char *text = punctuators[i].text;
+        size_t length = strlen(text);
+        int from = 0;
+        if (length > 1)
+        {
+            int prefix = find_punctuator(text, length - 1);
+            if (prefix < 0)
+            {
+                fprintf(stderr, "The prefix of \"%s\" is not a punctuator\n", text);
+                return 1;
+            }
+            from = prefix + 1;
+        }
+        next[from][classOf[(unsigned char)text[length - 1]]] = i + 1;
+    }
+
+    printf("#ifndef PUNCTUATORS_H\n#define PUNCTUATORS_H\n\n");
+    printf("// Generated by tools/gen_punctuators.c; do not edit.\n\n");
+    printf("#include <stddef.h>\n\n");
+
+    printf("typedef enum\n{\n");
+    for (int c = 0; c < FIXED_CLASS_COUNT; c++)
+    {
+        printf("    %s,\n", fixed_classes[c]);
+    }
+    printf("    CC_PUNCT, // first of the punctuator characters' classes\n");
+    printf("    CC_COUNT = %d\n} CharClass;\n\n", classCount);
+
+    printf("typedef enum\n{\n    PUNCT_NONE,\n");
+    for (int i = 0; i < PUNCTUATOR_COUNT; i++)
+    {
+        printf("    PUNCT_%s, // %s\n", punctuators[i].name, punctuators[i].text);
+    }
+    printf("    PUNCT_COUNT\n} Punctuator;\n\n");
+
+    printf("static const unsigned char char_class[256] = {\n");
+    for (int c = 0; c < 256; c++)
+    {
+        if (classOf[c] == 0)
+        {
+            continue;
+        }
+        int last = c;
+        while (last < 255 && classOf[last + 1] == classOf[c])
+        {
+            last++;
+        }
+        printf("    [");
+        print_char(c);
+        if (last > c)
+        {
+            printf(" ... ");
+            print_char(last);
+        }
+        printf("] = ");
+        print_class(classOf[c]);
+        printf(",\n");
+        c = last;
+    }
+    printf("};\n\n");
+
+    printf("// punct_next[state][class]: the punctuator read so far extended by one\n");
+    printf("// more character, or PUNCT_NONE when it cannot be.\n");
+    printf("static const unsigned char punct_next[PUNCT_COUNT][CC_COUNT] = {\n");
+    for (int state = 0; state <= PUNCTUATOR_COUNT; state++)
+    {
+        const char *separator = NULL;
+        for (int c = FIXED_CLASS_COUNT; c < classCount; c++)
+        {
+            if (!next[state][c])
+            {
+                continue;
+            }
+            if (!separator)
+            {
+                printf("    [PUNCT_%s] = {", state ? punctuators[state - 1].name : "NONE");
+                separator = "";
+            }
+            printf("%s[", separator);
+            print_class(c);
+            printf("] = PUNCT_%s", punctuators[next[state][c] - 1].name);
+            separator = ",\n        ";
+        }
+        if (separator)
+        {
+            printf("},\n");
+        }
+    }
+    printf("};\n\n");
+
+    printf("// The longest punctuator at p, or PUNCT_NONE if none starts there; *length\n");
+    printf("// is its length. One table lookup per byte.\n");
+    printf("static inline Punctuator punct_munch(const char *p, const char *end, size_t *length)\n{\n");
+    printf("    const char *start = p;\n");
+    printf("    unsigned state = PUNCT_NONE;\n");
+    printf("    while (p < end && punct_next[state][char_class[(unsigned char)*p]])\n    {\n");
+    printf("        state = punct_next[state][char_class[(unsigned char)*p++]];\n    }\n");
+    printf("    *length = p - start;\n");
+    printf("    return state;\n}\n\n#endif\n");
+    return 0;
+}
@@ -1,633 +1,438 @@
-#include <stdio.h>
-#include <stdlib.h>
+#define _XOPEN_SOURCE 700
+#include <errno.h>
+#include <ftw.h>
+#include <poll.h>
 #include <string.h>
-#include <ctype.h>
-#include <stdbool.h>
+#include <sys/inotify.h>
+#include "batch.h"
+#include "clock.h"
+#include "lexer.h"
+#include "libc2js.h"
+#include "source.h"
+
+// Without arguments, dumps the tokens of input.c. With a path, translates
+// every .c file under it (or the one file), then watches it with inotify and
+// re-translates each file that is written or moved into place. Events are
+// gathered until the tree has been quiet for the debounce time, so a burst
+// of writes to one file costs one translation. One context and one output
+// buffer stay warm across runs, and a file whose bytes did not change since
+// its last translation is skipped.
+// Usage: watch [PATH [-o OUTDIR] [--debounce MS]]
+
+// Events that mean a file has new contents, or a directory appeared.
+#define WATCH_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE)
+
+// A burst that never goes quiet is still translated after this many
+// debounce periods.
+#define WATCH_MAX_DEFER 10
 
-typedef enum
+typedef struct
 {
-    DATA_TYPES,
-    ID,
-    OP,
-    KEYWORDS,
-    NUM,
-    STRING,
-    CHAR,
-    COMMENT,
-    PUNCTUATORS,
-    LPAREN,
-    RPAREN,
-    LBRACE,
-    RBRACE,
-    LBRACKET,
-    RBRACKET,
-    SEMICOLON,
-    COMMA,
-    COLON,
-    DOT,
-    PREPROCESSOR,
-    T_EOF, // Changed from EOF to T_EOF to avoid conflict with standard EOF
-    UNKNOWN,
-    LOOP,
-    CONDITIONAL,
-    FUNCTION,
-    INPUTS,
-    OUTPUTS,
-    ASSIGNMENT
-} TokenType;
+    char *path; // NULL for an empty slot
+    uint64_t hash;
+    bool queued; // path is in pending
+} WatchedFile;
 
 typedef struct
 {
-    TokenType type;
-    char *value;
-    int line_no;
-} Token;
-
-Token *tokens;
-int tokenCount = 0;
-int currentToken = 0;
-
-const char *token_type_strings[] = {
-    "DATA_TYPES",
-    "ID",
-    "OP",
-    "KEYWORDS",
-    "NUM",
-    "STRING",
-    "CHAR",
-    "COMMENT",
-    "PUNCTUATORS",
-    "LPAREN",
-    "RPAREN",
-    "LBRACE",
-    "RBRACE",
-    "LBRACKET",
-    "RBRACKET",
-    "SEMICOLON",
-    "COMMA",
-    "COLON",
-    "DOT",
-    "PREPROCESSOR",
-    "T_EOF",
-    "UNKNOWN",
-    "LOOP",
-    "CONDITIONAL",
-    "FUNCTION",
-    "INPUTS",
-    "OUTPUTS",
-    "ASSIGNMENT"};
-
-const char *keywords[] = {
-    "auto", "break", "case", "const", "continue", "default", "do", "enum", "goto", "return"};
-
-const char *data_types[] = {
-    "int", "char", "float", "double", "void", "long long", "long", "short", "unsigned", "signed"};
-
-
-const char *loops[] = {
-    "for", "while", "do"};
-
-const char *conditionals[] = {
-    "if", "else", "switch", "case", "default"};
-
-const char *inputs[] = {
-    "scanf", "getchar", "getch", "getche"};
-
-const char *outputs[] = {
-    "printf", "putchar", "puts"};
-
-const char *functions[] = {
-    "strcmp", "strcpy"};
-
-
-// Token next();
-// Token peek();
-// void match(TokenType expected);
-// void program();
-// void external_declaration();
-// void function_definition();
-// void parameter_list();
-// void parameter();
-// void declaration();
-// void statement();
-// void expression_statement();
-// void return_statement();
-// void expression();
-// void term();
-// void factor();
-// void parse();
-// void for_statement();
-// void while_statement();
-// void do_while_statement();
-// void if_statement();
-// void else_statement();
-// void switch_statement();
-// void case_statement();
-// void default_statement();
-
-bool isKeyword(char *str)
+    int fd;
+    const char *root;
+    const char *onlyFile; // when watching a single file: its name
+    const char *outputDir;
+    int debounceMs;
+
+    char **dirs; // indexed by watch descriptor
+    int dirCapacity;
+
+    // Content hash of each file's last translation, and whether it is
+    // queued, by path.
+    WatchedFile *files;
+    size_t fileSlots;
+    size_t fileCount;
+
+    char **pending; // paths to translate, without duplicates; owned by files
+    int pendingCount;
+    int pendingCapacity;
+
+    C2jsContext *ctx;
+    OutputSink output;
+} Watcher;
+
+// For the nftw() callbacks.
+static Watcher *activeWatcher;
+
+// FNV-1a; only compared against earlier hashes of the same path.
+static uint64_t watch_hash(const char *data, size_t length)
 {
-    for (int i = 0; i < sizeof(keywords) / sizeof(keywords[0]); i++)
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < length; i++)
     {
-        if (strcmp(str, keywords[i]) == 0)
-        {
-            return true;
-        }
+        hash = (hash ^ (unsigned char)data[i]) * 1099511628211ull;
     }
-    return false;
+    return hash;
 }
 
-bool isDataType(char *str)
+static bool is_source(const char *name)
 {
-    for (int i = 0; i < sizeof(data_types) / sizeof(data_types[0]); i++)
-    {
-        if (strcmp(str, data_types[i]) == 0)
-        {
-            return true;
-        }
-    }
-    return false;
+    size_t length = strlen(name);
+    return length > 2 && strcmp(name + length - 2, ".c") == 0;
 }
 
-int isOperator(const char *str)
+static WatchedFile *watched_file(WatchedFile *files, size_t slots, const char *path)
 {
-    const char *operators[] = {
-        "+", "-", "*", "/", "%", "++", "--", "==", "!=", ">", "<", ">=", "<=", "&&", "||", "!", "&", "|", "^", "~", "<<", ">>", "sizeof", "?:"};
-    size_t n = sizeof(operators) / sizeof(operators[0]);
-    for (size_t i = 0; i < n; i++)
+    size_t slot = watch_hash(path, strlen(path)) & (slots - 1);
+    while (files[slot].path && strcmp(files[slot].path, path) != 0)
     {
-        if (strncmp(str, operators[i], strlen(operators[i])) == 0)
-        {
-            return 1;
-        }
+        slot = (slot + 1) & (slots - 1);
     }
-    return 0;
+    return &files[slot];
 }
 
-bool isLoop(char *str)
+// Returns the entry for path, adding it with hash 0, not queued, if it is
+// new. Entries move when the table grows, but their paths do not.
+static WatchedFile *lookup_file(Watcher *watcher, const char *path)
 {
-    for (int i = 0; i < sizeof(loops) / sizeof(loops[0]); i++)
+    if ((watcher->fileCount + 1) * 2 > watcher->fileSlots)
     {
-        if (strcmp(str, loops[i]) == 0)
+        size_t slots = watcher->fileSlots ? watcher->fileSlots * 2 : 256;
+        WatchedFile *files = calloc(slots, sizeof(WatchedFile));
+        for (size_t i = 0; i < watcher->fileSlots; i++)
         {
-            return true;
+            if (watcher->files[i].path)
+            {
+                *watched_file(files, slots, watcher->files[i].path) = watcher->files[i];
+            }
         }
+        free(watcher->files);
+        watcher->files = files;
+        watcher->fileSlots = slots;
     }
-    return false;
+    WatchedFile *file = watched_file(watcher->files, watcher->fileSlots, path);
+    if (!file->path)
+    {
+        file->path = strdup(path);
+        watcher->fileCount++;
+    }
+    return file;
 }
 
-bool isConditional(char *str)
+static void queue_file(Watcher *watcher, const char *path)
 {
-    for (int i = 0; i < sizeof(conditionals) / sizeof(conditionals[0]); i++)
+    WatchedFile *file = lookup_file(watcher, path);
+    if (file->queued)
     {
-        if (strcmp(str, conditionals[i]) == 0)
-        {
-            return true;
-        }
+        return;
+    }
+    file->queued = true;
+    if (watcher->pendingCount == watcher->pendingCapacity)
+    {
+        watcher->pendingCapacity = watcher->pendingCapacity ? watcher->pendingCapacity * 2 : 64;
+        watcher->pending = realloc(watcher->pending, sizeof(char *) * watcher->pendingCapacity);
     }
-    return false;
+    watcher->pending[watcher->pendingCount++] = file->path;
 }
 
-bool isFunction(char *str)
+static void add_watch(Watcher *watcher, const char *dir)
 {
-    for (int i = 0; i < sizeof(functions) / sizeof(functions[0]); i++)
+    int wd = inotify_add_watch(watcher->fd, dir, WATCH_EVENTS);
+    if (wd < 0)
     {
-        if (strcmp(str, functions[i]) == 0)
+        fprintf(stderr, "Failed to watch %s: %s\n", dir, strerror(errno));
+        return;
+    }
+    if (wd >= watcher->dirCapacity)
+    {
+        int capacity = watcher->dirCapacity ? watcher->dirCapacity : 64;
+        while (capacity <= wd)
         {
-            return true;
+            capacity *= 2;
         }
+        watcher->dirs = realloc(watcher->dirs, sizeof(char *) * capacity);
+        memset(watcher->dirs + watcher->dirCapacity, 0, sizeof(char *) * (capacity - watcher->dirCapacity));
+        watcher->dirCapacity = capacity;
     }
-    return false;
+    // Watching a directory twice returns the same descriptor.
+    free(watcher->dirs[wd]);
+    watcher->dirs[wd] = strdup(dir);
 }
 
-bool isInput(char *str)
+// Watches every directory under the path and queues every .c file.
+static int scan_entry(const char *path, const struct stat *st, int flag, struct FTW *ftw)
 {
-    for (int i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++)
+    if (flag == FTW_D)
     {
-        if (strcmp(str, inputs[i]) == 0)
-        {
-            return true;
-        }
+        add_watch(activeWatcher, path);
+    }
+    else if (flag == FTW_F && is_source(path))
+    {
+        queue_file(activeWatcher, path);
     }
-    return false;
+    return 0;
+}
+
+static void scan_tree(Watcher *watcher, const char *dir)
+{
+    activeWatcher = watcher;
+    nftw(dir, scan_entry, 64, FTW_PHYS);
 }
 
-bool isOutput(char *str)
+// Translates path if its contents changed since the last time. latency is
+// measured from the event that started the burst.
+static void translate_file(Watcher *watcher, const char *path, double burstStart)
 {
-    for (int i = 0; i < sizeof(outputs) / sizeof(outputs[0]); i++)
+    SourceFile source;
+    if (!source_open(path, &source))
     {
-        if (strcmp(str, outputs[i]) == 0)
+        // Deleted or renamed again before we got to it.
+        return;
+    }
+    WatchedFile *file = lookup_file(watcher, path);
+    uint64_t hash = watch_hash(source.data, source.length);
+    if (file->hash == hash && hash != 0)
+    {
+        source_close(&source);
+        return;
+    }
+
+    double start = now_seconds();
+    sink_reset(&watcher->output);
+    C2jsResult result = c2js_translate_buffer(watcher->ctx, source.data, source.length, &watcher->output);
+    const char *status = result == C2JS_OK              ? "ok"
+                         : result == C2JS_SYNTAX_ERROR   ? "syntax-error"
+                         : result == C2JS_SEMANTIC_ERROR ? "semantic-error"
+                                                         : "too-large";
+    if (result == C2JS_OK)
+    {
+        char *outputPath = batch_output_path(path, watcher->onlyFile ? NULL : watcher->root, watcher->outputDir);
+        batch_make_parent_dirs(outputPath);
+        if (!sink_save(&watcher->output, outputPath))
         {
-            return true;
+            status = "io-error";
         }
+        free(outputPath);
     }
-    return false;
+    // Only a successful translation is remembered, so a file that failed is
+    // retried on its next event even if it did not change.
+    file->hash = result == C2JS_OK ? hash : 0;
+    double end = now_seconds();
+    printf("%-14s %10zu bytes %9.3f ms translate %9.3f ms since event  %s", status, source.length, (end - start) * 1e3,
+           burstStart > 0 ? (end - burstStart) * 1e3 : 0.0, path);
+    if (result == C2JS_SYNTAX_ERROR)
+    {
+        printf(" (line %d, column %d)", c2js_error_line(watcher->ctx), c2js_error_column(watcher->ctx));
+    }
+    printf("\n");
+    fflush(stdout);
+    source_close(&source);
 }
 
-int isAssignment(const char *str)
+static void translate_pending(Watcher *watcher, double burstStart)
 {
-    const char *assignments[] = {
-        "=", "+=", "-=", "*=", "/=", "%=", "&=", "|=", "^=", "<<=", ">>="};
-    size_t n = sizeof(assignments) / sizeof(assignments[0]);
-    for (size_t i = 0; i < n; i++)
+    for (int i = 0; i < watcher->pendingCount; i++)
     {
-        if (strncmp(str, assignments[i], strlen(assignments[i])) == 0)
-        {
-            return 1;
-        }
+        lookup_file(watcher, watcher->pending[i])->queued = false;
+        translate_file(watcher, watcher->pending[i], burstStart);
     }
-    return 0;
+    watcher->pendingCount = 0;
 }
 
-Token *tokenize(const char *code, int *tokenCount)
+// Reads the events that are ready and queues what they touch. Returns false
+// if the descriptor failed.
+static bool read_events(Watcher *watcher)
 {
-    Token *tokens = malloc(sizeof(Token) * 2048);
-    *tokenCount = 0;
-    int lineNo = 1;
-
-    for (int i = 0; i < strlen(code); i++)
+    char buffer[64 * 1024] __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t length = read(watcher->fd, buffer, sizeof(buffer));
+    if (length < 0)
     {
-        char c = code[i];
-        if (c == '\n')
-        {
-            lineNo++;
-            continue;
-        }
-        if (c == ' ')
-            continue;
+        return errno == EINTR || errno == EAGAIN;
+    }
+    for (char *p = buffer; p < buffer + length;)
+    {
+        const struct inotify_event *event = (const struct inotify_event *)p;
+        p += sizeof(struct inotify_event) + event->len;
 
-        if (isdigit(c))
+        if (event->mask & IN_Q_OVERFLOW)
         {
-            int start = i;
-            while (isdigit(code[i]))
+            // Events were lost; the hashes skip whatever did not change.
+            if (watcher->onlyFile)
             {
-                i++;
-            }
-            char *num = strndup(code + start, i - start);
-            tokens[(*tokenCount)++] = (Token){NUM, num, lineNo};
-            i--;
-        }
-        else if (isalpha(c) || c == '_')
-        {
-            int start = i;
-            while (isalnum(code[i]) || code[i] == '_')
-            {
-                i++;
-            }
-            char *id = strndup(code + start, i - start);
-            if (isKeyword(id))
-            {
-                tokens[(*tokenCount)++] = (Token){KEYWORDS, id, lineNo};
-            }
-            else if (isDataType(id))
-            {
-                tokens[(*tokenCount)++] = (Token){DATA_TYPES, id, lineNo};
-            }
-            else if (isLoop(id))
-            {
-                tokens[(*tokenCount)++] = (Token){LOOP, id, lineNo};
-            }
-            else if (isConditional(id))
-            {
-                tokens[(*tokenCount)++] = (Token){CONDITIONAL, id, lineNo};
-            }
-            else if (isFunction(id))
-            {
-                tokens[(*tokenCount)++] = (Token){FUNCTION, id, lineNo};
-            }
-            else if (isInput(id))
-            {
-                tokens[(*tokenCount)++] = (Token){INPUTS, id, lineNo};
-            }
-            else if (isOutput(id))
-            {
-                tokens[(*tokenCount)++] = (Token){OUTPUTS, id, lineNo};
-            }
-            else if (isAssignment(id))
-            {
-                tokens[(*tokenCount)++] = (Token){ASSIGNMENT, id, lineNo};
+                queue_file(watcher, watcher->root);
             }
             else
             {
-                tokens[(*tokenCount)++] = (Token){ID, id, lineNo};
+                scan_tree(watcher, watcher->root);
             }
-            i--;
+            continue;
         }
-        else if (isAssignment(code + i))
+        if (event->wd < 0 || event->wd >= watcher->dirCapacity || !watcher->dirs[event->wd])
         {
-            int start = i;
-            while (isAssignment(code + i))
-            {
-                i++;
-            }
-            char *op = strndup(code + start, i - start);
-            tokens[(*tokenCount)++] = (Token){ASSIGNMENT, op, lineNo};
-            i--;
+            continue;
         }
-        else if (isOperator(code + i))
+        if (event->mask & IN_IGNORED)
         {
-            int start = i;
-            while (isOperator(code + i))
-            {
-                i++;
-            }
-            char *op = strndup(code + start, i - start);
-            tokens[(*tokenCount)++] = (Token){OP, op, lineNo};
-            i--;
+            // The directory was removed.
+            free(watcher->dirs[event->wd]);
+            watcher->dirs[event->wd] = NULL;
+            continue;
         }
-        else if (c == '"')
+        if (event->len == 0)
         {
-            int start = i + 1;
-            while (code[i + 1] != '"' && code[i + 1] != '\0')
-            {
-                i++;
-            }
-            char *str = strndup(code + start, i - start + 1);
-            tokens[(*tokenCount)++] = (Token){STRING, str, lineNo};
-            i++;
+            continue;
         }
-        else if (c == '\'')
+
+        const char *dir = watcher->dirs[event->wd];
+        char *path = malloc(strlen(dir) + strlen(event->name) + 2);
+        sprintf(path, "%s/%s", dir, event->name);
+        if (event->mask & IN_ISDIR)
         {
-            int start = ++i;
-            while (code[i] != '\'' && code[i] != '\0')
+            if (!watcher->onlyFile)
             {
-                i++;
+                // A new or moved-in directory may already hold files.
+                scan_tree(watcher, path);
             }
-            char *str = strndup(code + start, i - start);
-            tokens[(*tokenCount)++] = (Token){CHAR, str, lineNo};
         }
-        else if (c == '#')
+        else if (watcher->onlyFile ? strcmp(event->name, watcher->onlyFile) == 0 : is_source(event->name))
         {
-            int start = i;
-            while (code[i] != '\n' && code[i] != '\0')
+            // IN_CREATE alone is followed by IN_CLOSE_WRITE once written.
+            if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
             {
-                i++;
+                queue_file(watcher, watcher->onlyFile ? watcher->root : path);
             }
-            char *directive = strndup(code + start, i - start);
-            tokens[(*tokenCount)++] = (Token){PREPROCESSOR, directive, lineNo};
-        }
-        else if (c == '(')
-        {
-            tokens[(*tokenCount)++] = (Token){LPAREN, strdup("("), lineNo};
-        }
-        else if (c == ')')
-        {
-            tokens[(*tokenCount)++] = (Token){RPAREN, strdup(")"), lineNo};
-        }
-        else if (c == '{')
-        {
-            tokens[(*tokenCount)++] = (Token){LBRACE, strdup("{"), lineNo};
-        }
-        else if (c == '}')
-        {
-            tokens[(*tokenCount)++] = (Token){RBRACE, strdup("}"), lineNo};
         }
-        else if (c == '[')
-        {
-            tokens[(*tokenCount)++] = (Token){LBRACKET, strdup("["), lineNo};
-        }
-        else if (c == ']')
-        {
-            tokens[(*tokenCount)++] = (Token){RBRACKET, strdup("]"), lineNo};
-        }
-        else if (c == ';')
-        {
-            tokens[(*tokenCount)++] = (Token){SEMICOLON, strdup(";"), lineNo};
-        }
-        else if (c == ',')
-        {
-            tokens[(*tokenCount)++] = (Token){COMMA, strdup(","), lineNo};
-        }
-        else if (c == ':')
-        {
-            tokens[(*tokenCount)++] = (Token){COLON, strdup(":"), lineNo};
-        }
-        else if (c == '.')
+        free(path);
+    }
+    return true;
+}
+
+static int run_watch(const char *root, const char *outputDir, int debounceMs)
+{
+    struct stat st;
+    if (stat(root, &st) != 0)
+    {
+        perror(root);
+        return 1;
+    }
+
+    Watcher watcher = {.root = root, .outputDir = outputDir, .debounceMs = debounceMs};
+    watcher.fd = inotify_init1(IN_CLOEXEC);
+    if (watcher.fd < 0)
+    {
+        perror("inotify_init1");
+        return 1;
+    }
+    watcher.ctx = c2js_context_new();
+    c2js_set_trace_level(watcher.ctx, C2JS_TRACE_ERROR);
+    sink_init_memory(&watcher.output);
+
+    if (S_ISDIR(st.st_mode))
+    {
+        scan_tree(&watcher, root);
+    }
+    else
+    {
+        // Editors often save by renaming a new file over the old one, which
+        // ends a watch on the file itself, so watch its directory instead.
+        char *dir = strdup(root);
+        char *slash = strrchr(dir, '/');
+        watcher.onlyFile = slash ? root + (slash - dir) + 1 : root;
+        if (slash)
         {
-            tokens[(*tokenCount)++] = (Token){DOT, strdup("."), lineNo};
+            *slash = '\0';
         }
-        else if (isOperator(&c))
+        add_watch(&watcher, slash ? (dir[0] ? dir : "/") : ".");
+        free(dir);
+        queue_file(&watcher, root);
+    }
+    translate_pending(&watcher, 0);
+    printf("Watching %s\n", root);
+    fflush(stdout);
+
+    struct pollfd pfd = {.fd = watcher.fd, .events = POLLIN};
+    for (;;)
+    {
+        if (poll(&pfd, 1, -1) < 0)
         {
-            int start = i;
-            while (isOperator(&code[i]))
+            if (errno == EINTR)
             {
-                i++;
+                continue;
             }
-            char *op = strndup(code + start, i - start);
-            tokens[(*tokenCount)++] = (Token){OP, op, lineNo};
-            i--;
+            perror("poll");
+            break;
         }
-        else if (c == '/')
+        double burstStart = now_seconds();
+        if (!read_events(&watcher))
         {
-            if (code[i + 1] == '/')
-            {
-                while (code[i] != '\n' && code[i] != '\0')
-                {
-                    i++;
-                }
-                // Skip the comment and do not add to token stream
-            }
-            else if (code[i + 1] == '*')
-            {
-                while (!(code[i] == '*' && code[i + 1] == '/'))
-                {
-                    i++;
-                }
-                i += 2;
-                // Skip the comment and do not add to token stream
-            }
-            else
-            {
-                printf("Unknown token: %c\n", c);
-                char *unknown = malloc(2);
-                unknown[0] = c;
-                unknown[1] = '\0';
-                tokens[(*tokenCount)++] = (Token){UNKNOWN, unknown, lineNo};
-            }
+            perror("inotify");
+            break;
         }
-        else
+        // Debounce: keep collecting until a quiet period, or the cap.
+        for (int deferred = 0; deferred < WATCH_MAX_DEFER && poll(&pfd, 1, debounceMs) > 0; deferred++)
         {
-            if(isAssignment(&c)){
-                int start = i;
-                while (isAssignment(code + i))
-                {
-                    i++;
-                }
-                char *op = strndup(code + start, i - start);
-                tokens[(*tokenCount)++] = (Token){ASSIGNMENT, op, lineNo};
-                i--;
-            }else if(isOperator(&c)){
-                int start = i;
-                while (isOperator(&code[i]))
-                {
-                    i++;
-                }
-                char *op = strndup(code + start, i - start);
-                tokens[(*tokenCount)++] = (Token){OP, op, lineNo};
-                i--;
-            }else{
-            char *unknown = malloc(2);
-            unknown[0] = c;
-            unknown[1] = '\0';
-            tokens[(*tokenCount)++] = (Token){UNKNOWN, unknown, lineNo};
-            }
+            read_events(&watcher);
         }
+        translate_pending(&watcher, burstStart);
     }
 
-    tokens[(*tokenCount)++] = (Token){T_EOF, strdup("EOF"), lineNo};
-    return tokens;
-}
-
-void print_tokens(Token *tokens, int tokenCount)
-{
-    for (int i = 0; i < tokenCount; i++)
-    {
-        printf("<%s, %s, %d>\n", token_type_strings[tokens[i].type], tokens[i].value, tokens[i].line_no);
-    }
-}
-
-char *read_file(const char *filename)
-{
-    FILE *file = fopen(filename, "r");
-    if (!file)
-    {
-        perror("Failed to open file");
-        exit(EXIT_FAILURE);
-    }
-    fseek(file, 0, SEEK_END);
-    long length = ftell(file);
-    fseek(file, 0, SEEK_SET);
-    char *buffer = malloc(length + 1);
-    if (!buffer)
-    {
-        perror("Failed to allocate buffer");
-        exit(EXIT_FAILURE);
-    }
-    fread(buffer, 1, length, file);
-    buffer[length] = '\0';
-    fclose(file);
-    return buffer;
+    sink_close(&watcher.output);
+    c2js_context_free(watcher.ctx);
+    close(watcher.fd);
+    return 1;
 }
 
-// Syntax Analysis
-// Token next()
-// {
-//     return tokens[currentToken++];
-// }
-
-// Token peek()
-// {
-//     return tokens[currentToken];
-// }
-
-// void parse()
-// {
-//     currentToken = 0;
-//     program();
-//     if (tokens[currentToken].type == T_EOF)
-//     {
-//         printf("Parsing successful\n");
-//     }
-//     else
-//     {
-//         printf("Parsing failed\n");
-//     }
-// }
-
-// void program()
-// {
-//     while (tokens[currentToken].type != T_EOF)
-//     {
-//         external_declaration();
-//     }
-// }
-
-// void external_declaration()
-// {
-//     if (tokens[currentToken].type == DATA_TYPES)
-//     {
-//         if (tokens[currentToken + 2].type == LPAREN)
-//         {
-//             function_definition();
-//         }
-//         else
-//         {
-//             declaration();
-//         }
-//     }
-//     else if (tokens[currentToken].type == PREPROCESSOR)
-//     {
-//         match(PREPROCESSOR);
-//     }
-// }
-
-// void function_definition()
-// {
-//     match(DATA_TYPES);
-//     match(ID);
-//     match(LPAREN);
-//     while (tokens[currentToken].type != RBRACE)
-//     {
-//         parameter_list();
-//     }
-//     match(RPAREN);
-//     match(LBRACE);
-//     while (tokens[currentToken].type != RBRACE)
-//     {
-//         statement();
-//     }
-//     match(RBRACE);
-// }
-
-// void parameter_list()
-// {
-//     parameter();
-//     while (tokens[currentToken].type == COMMA)
-//     {
-//         match(COMMA);
-//         parameter();
-//     }
-// }
-
-// void parameter()
-// {
-//     match(DATA_TYPES);
-//     match(ID);
-// }
-
-// void declaration()
-// {
-//     int type = tokens[currentToken].type;
-//     if (type == DATA_TYPES)
-//     {
-//         match(DATA_TYPES);
-//         match(ID);
-//         while (tokens[currentToken].type == COMMA)
-//         {
-//             match(COMMA);
-//             match(ID);
-//         }
-//     }
-// }
-
-int main()
+static int dump_tokens()
 {
     const char *filename = "input.c";
-    char *code = read_file(filename);
+    SourceFile source;
+    read_file(filename, &source);
 
-    // Use the global tokens array
-    tokens = tokenize(code, &tokenCount);
+    Arena arena;
+    Interner interner;
+    TokenStream tokens = {0};
+    LineIndex lines = {0};
+    arena_init(&arena);
+    interner_init(&interner, &arena);
+    tokenize(&interner, &tokens, source.data, source.length);
+    line_index_build(&lines, source.data, source.length);
 
-    print_tokens(tokens, tokenCount);
-    // parse();
+    print_tokens(stdout, source.data, &tokens, &lines);
 
     // Free allocated memory
-    for (int i = 0; i < tokenCount; i++)
-    {
-        free(tokens[i].value);
-    }
-    free(tokens);
-    free(code);
+    line_index_free(&lines);
+    token_stream_free(&tokens);
+    arena_free(&arena);
+    source_close(&source);
 
     return 0;
 }
+
+int main(int argc, char **argv)
+{
+    const char *root = NULL;
+    const char *outputDir = NULL;
+    int debounceMs = 5;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+        {
+            outputDir = argv[++i];
+        }
+        else if (strcmp(argv[i], "--debounce") == 0 && i + 1 < argc)
+        {
+            debounceMs = atoi(argv[++i]);
+        }
+        else if (!root && argv[i][0] != '-')
+        {
+            root = argv[i];
+        }
+        else
+        {
+            fprintf(stderr, "usage: watch               dump the tokens of input.c\n"
+                            "       watch PATH [-o OUTDIR] [--debounce MS]\n"
+                            "                           translate the .c files under PATH (or the\n"
+                            "                           file PATH), then again whenever one changes;\n"
+                            "                           events are batched until MS (default 5) quiet\n");
+            return 2;
+        }
+    }
+    return root ? run_watch(root, outputDir, debounceMs) : dump_tokens();
+}